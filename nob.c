@@ -19,6 +19,18 @@ int build_obj_test(Nob_Cmd *const cmd) {
     return nob_cmd_run_sync_and_reset(cmd);
 }
 
+int build_bench(Nob_Cmd *const cmd) {
+    nob_cmd_append(cmd, "clang", "-Wall", "-Wextra", "-O2", "-o",
+                   BUILD_DIR "bench", SRC_DIR "moluvi.c", SRC_DIR "bench.c");
+    return nob_cmd_run_sync_and_reset(cmd);
+}
+
+int build_meshc(Nob_Cmd *const cmd) {
+    nob_cmd_append(cmd, "clang", "-Wall", "-Wextra", "-O2", "-o",
+                   BUILD_DIR "meshc", SRC_DIR "moluvi.c", SRC_DIR "meshc.c");
+    return nob_cmd_run_sync_and_reset(cmd);
+}
+
 int build_example(Nob_Cmd *const cmd) {
     nob_cmd_append(cmd, "clang", "-Wall", "-Wextra", /*"-Weverything",*/ "-o",
                    BUILD_DIR "example", SRC_DIR "example.c",
@@ -47,5 +59,9 @@ int main(int argc, char **argv) {
         return !build_example(&cmd);
     } else if (strcmp(target, "test-obj") == 0) {
         return !build_obj_test(&cmd);
+    } else if (strcmp(target, "bench") == 0) {
+        return !build_bench(&cmd);
+    } else if (strcmp(target, "meshc") == 0) {
+        return !build_meshc(&cmd);
     }
 }
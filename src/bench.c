@@ -0,0 +1,730 @@
+#include <float.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "font_mojangles.h"
+#include "moluvi.h"
+
+#define WIDTH 1000
+#define HEIGHT 1000
+#define FRAMES 60
+#define ANGULAR_STEP 0.05
+
+static canvas_t canvas;
+
+static struct camera cam = {
+    .dist = 1000,
+    .focal_len = 1000,
+    .width = WIDTH,
+    .height = HEIGHT,
+};
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Finds the scale and center that fit the mesh into about 80% of the canvas.
+ */
+static float mesh_fit(const obj_t *const obj, point3_t *center) {
+    point3_t lo = obj->bounds_min;
+    point3_t hi = obj->bounds_max;
+    *center = (point3_t){(lo.x + hi.x) / 2, (lo.y + hi.y) / 2,
+                         (lo.z + hi.z) / 2};
+    float extent = MAX(MAX(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z);
+    return 0.8f * (float)MIN(WIDTH, HEIGHT) / extent;
+}
+
+/**
+ * Renders the mesh for FRAMES frames, rotating it like obj_example, and
+ * reports how many triangles per second made it through canvas_draw_mesh.
+ * With a binner, triangles are queued and rasterized in parallel instead.
+ * cull selects the back-face culling of the camera, and optimize runs
+ * obj_optimize on the mesh first.
+ */
+static void bench_mesh(const char *filename, binner_t *const binner,
+                       enum cull_mode cull, bool optimize) {
+    obj_t obj;
+    if (obj_load(&obj, filename) < 0) {
+        fprintf(stderr, "Could not load %s\n", filename);
+        return;
+    }
+    if (optimize && obj_optimize(&obj) < 0) {
+        fprintf(stderr, "Could not optimize %s\n", filename);
+        obj_cleanup(&obj);
+        return;
+    }
+
+    point3_t mesh_center;
+    float scale = mesh_fit(&obj, &mesh_center);
+    struct camera mesh_cam = cam;
+    mesh_cam.cull = cull;
+
+    size_t drawn = 0;
+    uint64_t hiz_pixels = 0, hiz_tris = 0;
+    struct cull_stats culled = {0};
+    double raster_time = 0;
+    uint64_t allocs = 0;
+    for (int frame = 0; frame < FRAMES; frame++) {
+        // The first frame sizes the scratch space
+        if (frame == 1)
+            allocs = heap_alloc_count();
+        canvas_fill(&canvas, COLOR_BLACK);
+        canvas_depth_reset(&canvas);
+
+        double start = now_sec();
+        struct transform model =
+            transform_model(mesh_center, scale, ANGULAR_STEP * frame);
+        int ret = binner ? binner_draw_mesh(binner, &obj, &model, mesh_cam)
+                         : canvas_draw_mesh(&canvas, &obj, &model, mesh_cam);
+        if (ret > 0)
+            drawn += ret;
+        if (binner)
+            binner_flush(binner);
+        raster_time += now_sec() - start;
+
+        struct depth_stats stats = canvas_depth_stats(&canvas);
+        hiz_pixels += stats.pixels_culled;
+        hiz_tris += stats.tris_culled;
+
+        struct cull_stats cull_stats = canvas_cull_stats(&canvas);
+        culled.backface += cull_stats.backface;
+        culled.frustum += cull_stats.frustum;
+        culled.degenerate += cull_stats.degenerate;
+    }
+    allocs = heap_alloc_count() - allocs;
+
+    printf("%-6s %-4s %-3s %-20s faces=%-6zu drawn/frame=%-6zu "
+           "%7.2f ms/frame %10.0f tris/sec\n",
+           binner ? "binned" : "direct", cull == CULL_NONE ? "" : "cull",
+           optimize ? "opt" : "", filename, obj_face_count(&obj),
+           drawn / FRAMES, raster_time * 1000 / FRAMES,
+           (double)(obj_face_count(&obj) * FRAMES) / raster_time);
+    printf("       hi-z culled/frame: %" PRIu64 " tris, %" PRIu64 " px\n",
+           hiz_tris / FRAMES, hiz_pixels / FRAMES);
+    printf("       culled/frame: %" PRIu64 " back-facing, %" PRIu64
+           " outside frustum, %" PRIu64 " zero area\n",
+           culled.backface / FRAMES, culled.frustum / FRAMES,
+           culled.degenerate / FRAMES);
+    printf("       heap allocations after the first frame: %" PRIu64 "\n",
+           allocs);
+
+    obj_cleanup(&obj);
+}
+
+/**
+ * Compares clearing the canvas with canvas_fill against a plain memset of the
+ * same buffer.
+ */
+static void bench_clear(void) {
+    size_t bytes = (size_t)canvas.stride * HEIGHT * sizeof(struct rgba);
+    int reps = FRAMES * 10;
+
+    double start = now_sec();
+    for (int i = 0; i < reps; i++)
+        canvas_fill(&canvas, (struct rgba){(uint8_t)i, 0, 0, 255});
+    double fill_time = (now_sec() - start) / reps;
+
+    start = now_sec();
+    for (int i = 0; i < reps; i++)
+        memset(canvas.data, i, bytes);
+    double memset_time = (now_sec() - start) / reps;
+
+    printf("clear  canvas_fill %7.3f ms/frame, memset %7.3f ms/frame\n",
+           fill_time * 1000, memset_time * 1000);
+}
+
+/**
+ * Times a mostly empty frame, a clear and a small rectangle, cleared with
+ * canvas_fill and canvas_depth_reset, and with canvas_clear and resolved for
+ * presenting. The fast clear is timed both with the same color every frame,
+ * which leaves the untouched tiles alone, and with a new one.
+ */
+static void bench_fast_clear(void) {
+    static const char *const names[] = {"eager", "fast", "fast-new-color"};
+    int reps = FRAMES * 10;
+    for (int mode = 0; mode < 3; mode++) {
+        double start = now_sec();
+        for (int i = 0; i < reps; i++) {
+            struct rgba bg = {0, 0, mode == 2 ? (uint8_t)i : 0, 255};
+            if (mode == 0) {
+                canvas_fill(&canvas, bg);
+                canvas_depth_reset(&canvas);
+            } else {
+                canvas_clear(&canvas, bg);
+            }
+            canvas_fill_rect(&canvas, 10, 10, 100, 20, COLOR_WHITE);
+            canvas_resolve(&canvas);
+        }
+        double time = (now_sec() - start) / reps;
+        printf("clear  %-14s %7.3f ms/frame\n", names[mode], time * 1000);
+    }
+}
+
+/**
+ * Frames that clear the canvas and redraw only a bar growing like a counter,
+ * and how much of each one dirty tracking reports as changed.
+ */
+static void bench_dirty(void) {
+    int reps = FRAMES * 10;
+    canvas_t hud;
+    arraylist_t rects;
+    if (canvas_init(&hud, WIDTH, HEIGHT, COLOR_BLACK) < 0 ||
+        canvas_track_dirty(&hud) < 0 ||
+        ARRAY_MAKE(&rects, struct dirty_rect, 64) < 0)
+        return;
+
+    uint64_t dirty_px = 0;
+    double start = now_sec();
+    for (int i = 0; i < reps; i++) {
+        canvas_dirty_reset(&hud);
+        canvas_clear(&hud, COLOR_BLACK);
+        canvas_fill_rect(&hud, 10, 10, 20 + i % 100, 24, COLOR_WHITE);
+        canvas_resolve(&hud);
+        int count = canvas_dirty_rects(&hud, &rects);
+        if (count < 0)
+            break;
+        const struct dirty_rect *r = rects.data;
+        for (int j = 0; j < count; j++)
+            dirty_px += (uint64_t)r[j].width * r[j].height;
+    }
+    double time = (now_sec() - start) / reps;
+
+    printf("dirty  counter frame %7.3f ms/frame, %5.2f%% of pixels dirty\n",
+           time * 1000, 100.0 * dirty_px / reps / (WIDTH * HEIGHT));
+    array_cleanup(&rects);
+    canvas_cleanup(&hud);
+}
+
+/**
+ * Blends a translucent color, and a layer with varying alpha, over the whole
+ * canvas.
+ */
+static void bench_blend(void) {
+    int reps = FRAMES * 2;
+    canvas_t layer;
+    canvas_init(&layer, WIDTH, HEIGHT, COLOR_BLACK);
+    for (uint32_t i = 0; i < WIDTH * HEIGHT; i++)
+        layer.data[i / WIDTH * layer.stride + i % WIDTH].a = (uint8_t)(i * 7);
+
+    double start = now_sec();
+    for (int i = 0; i < reps; i++)
+        canvas_fill_rect(&canvas, 0, 0, WIDTH, HEIGHT, C(0x80FF8040));
+    double rect_time = (now_sec() - start) / reps;
+
+    start = now_sec();
+    for (int i = 0; i < reps; i++)
+        canvas_blend_canvas(&canvas, &layer, 0, 0);
+    double layer_time = (now_sec() - start) / reps;
+
+    printf("blend  canvas_fill_rect %7.3f ms/frame, canvas_blend_canvas "
+           "%7.3f ms/frame\n",
+           rect_time * 1000, layer_time * 1000);
+    canvas_cleanup(&layer);
+}
+
+/**
+ * Draws as many circles as points_example does each frame.
+ */
+static void bench_circles(void) {
+    int reps = FRAMES;
+    double times[2];
+    for (int aa = 0; aa < 2; aa++) {
+        double start = now_sec();
+        for (int i = 0; i < reps; i++) {
+            for (uint32_t j = 0; j < 1000; j++) {
+                int64_t x = (j * 37) % WIDTH;
+                int64_t y = (j * 91) % HEIGHT;
+                uint32_t r = 5 + j % 20;
+                struct rgba color = {(uint8_t)j, 128, 200, 255};
+                if (aa)
+                    canvas_fill_circle_aa(&canvas, x, y, r, color);
+                else
+                    canvas_fill_circle(&canvas, x, y, r, color);
+            }
+        }
+        times[aa] = (now_sec() - start) / reps;
+    }
+
+    printf("circle 1000x canvas_fill_circle %7.3f ms/frame, "
+           "canvas_fill_circle_aa %7.3f ms/frame\n",
+           times[0] * 1000, times[1] * 1000);
+}
+
+/**
+ * Draws the circles of bench_circles through a command buffer, replayed by
+ * the binner's threads.
+ */
+static void bench_cmd_buffer(void) {
+    int reps = FRAMES;
+    cmd_buffer_t cmds;
+    binner_t binner;
+    if (cmd_buffer_init(&cmds) < 0 || binner_init(&binner, &canvas, 0) < 0)
+        return;
+
+    double start = now_sec();
+    for (int i = 0; i < reps; i++) {
+        cmd_buffer_reset(&cmds);
+        for (uint32_t j = 0; j < 1000; j++) {
+            int64_t x = (j * 37) % WIDTH;
+            int64_t y = (j * 91) % HEIGHT;
+            uint32_t r = 5 + j % 20;
+            struct rgba color = {(uint8_t)j, 128, 200, 255};
+            cmd_fill_circle_aa(&cmds, x, y, r, color);
+        }
+        cmd_buffer_execute(&cmds, &binner);
+    }
+    double time = (now_sec() - start) / reps;
+
+    printf("cmd    1000x cmd_fill_circle_aa %7.3f ms/frame\n", time * 1000);
+    binner_cleanup(&binner);
+    cmd_buffer_cleanup(&cmds);
+}
+
+/**
+ * Writes a screen of text in color through cache if it is not NULL, its lines
+ * cycling through the sizes 1 to max_size.
+ */
+static void bench_text_with(text_cache_t *const cache, uint32_t max_size,
+                            struct rgba color, const char *name) {
+    static const char *const line =
+        "Fruit Consumption vs All-cause Mortality 0123456789 FPS 60 FRAME 1024 "
+        "DRAW CALLS 312 TRIS 48210 ALLOCS 0";
+    uint32_t spacing = 10 * max_size;
+    int reps = FRAMES;
+    size_t chars = 0;
+    double start = now_sec();
+    for (int i = 0; i < reps; i++) {
+        for (uint32_t y = 0; y + 8 * max_size < HEIGHT; y += spacing) {
+            uint32_t size = 1 + y / spacing % max_size;
+            size_t len = MIN(strlen(line), (WIDTH - 20) / (8 * size) - 1);
+            char text[128];
+            memcpy(text, line, len);
+            text[len] = '\0';
+            if (cache)
+                canvas_write_string_cached(&canvas, cache, text, 10, y,
+                                           font_mojangles, size, color);
+            else
+                canvas_write_string(&canvas, text, 10, y, font_mojangles,
+                                    size, color);
+            chars += len;
+        }
+    }
+    double time = (now_sec() - start) / reps;
+
+    printf("text   %5zu chars, sizes 1-%u %-38s %7.3f ms/frame\n",
+           chars / reps, max_size, name, time * 1000);
+}
+
+/**
+ * A screen of lines of every size from 1 to 4, and one of HUD sized lines,
+ * drawn directly and from a text cache that holds every line.
+ */
+static void bench_text(void) {
+    text_cache_t cache;
+    if (text_cache_init(&cache, 4 << 20) < 0)
+        return;
+    static const uint32_t max_sizes[] = {4, 1};
+    for (size_t i = 0; i < sizeof(max_sizes) / sizeof(max_sizes[0]); i++) {
+        uint32_t max_size = max_sizes[i];
+        bench_text_with(NULL, max_size, COLOR_WHITE, "canvas_write_string");
+        bench_text_with(NULL, max_size, C(0x80FFFFFF),
+                        "canvas_write_string translucent");
+        bench_text_with(&cache, max_size, COLOR_WHITE,
+                        "canvas_write_string_cached");
+        bench_text_with(&cache, max_size, C(0x80FFFFFF),
+                        "canvas_write_string_cached translucent");
+    }
+    text_cache_cleanup(&cache);
+}
+
+/**
+ * Times load on the file, best of a few runs.
+ */
+static void bench_load_with(int (*load)(obj_t *const, const char *),
+                            const char *name, const char *filename,
+                            const char *label) {
+    double best = 0;
+    obj_t obj = {0};
+
+    // The first run leaves a cache behind for the others
+    for (int i = 0; i < 5; i++) {
+        double start = now_sec();
+        if (load(&obj, filename) < 0) {
+            fprintf(stderr, "Could not load %s\n", filename);
+            return;
+        }
+        double time = now_sec() - start;
+        best = i == 0 ? time : MIN(best, time);
+        if (i < 4)
+            obj_cleanup(&obj);
+    }
+
+    printf("%-6s %-27s vertices=%-8zu faces=%-8zu %9.3f ms\n", name, label,
+           obj_vertex_count(&obj), obj_face_count(&obj), best * 1000);
+    obj_cleanup(&obj);
+}
+
+/**
+ * Times parsing the file with obj_load, then mapping its mesh cache with
+ * obj_load_cached.
+ */
+static void bench_load(const char *filename, const char *label) {
+    bench_load_with(&obj_load, "load", filename, label);
+    bench_load_with(&obj_load_cached, "cached", filename, label);
+}
+
+/**
+ * Writes a grid of (n + 1)^2 vertices and 2 * n^2 faces to a temporary OBJ
+ * file and times loading it.
+ */
+static void bench_load_synthetic(uint32_t n) {
+    char filename[] = "/tmp/moluvi-bench-XXXXXX";
+    int fd = mkstemp(filename);
+    FILE *file = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if (!file) {
+        perror("Could not create synthetic mesh");
+        return;
+    }
+
+    fprintf(file, "# %u x %u grid\n", n, n);
+    for (uint32_t i = 0; i <= n; i++) {
+        for (uint32_t j = 0; j <= n; j++)
+            fprintf(file, "v %f %f %f\n", (float)i / n - 0.5f,
+                    (float)j / n - 0.5f, (float)((i * 7 + j * 13) % 101) / 1000);
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = 0; j < n; j++) {
+            uint32_t a = i * (n + 1) + j + 1;
+            fprintf(file, "f %u %u %u\nf %u %u %u\n", a, a + n + 1, a + 1,
+                    a + 1, a + n + 1, a + n + 2);
+        }
+    }
+    fclose(file);
+
+    bench_load(filename, "synthetic grid");
+
+    char cache_path[sizeof(filename) + 5];
+    snprintf(cache_path, sizeof(cache_path), "%s.mesh", filename);
+    unlink(cache_path);
+    unlink(filename);
+}
+
+/**
+ * Reports the average cache miss ratio of the mesh before and after
+ * obj_optimize, for a few cache sizes, and how long optimizing took.
+ */
+static void bench_optimize(const char *filename, const char *label) {
+    obj_t obj;
+    if (obj_load(&obj, filename) < 0) {
+        fprintf(stderr, "Could not load %s\n", filename);
+        return;
+    }
+
+    const uint32_t cache_sizes[] = {8, 16, 32};
+    float before[3];
+    for (int i = 0; i < 3; i++)
+        before[i] = obj_acmr(&obj, cache_sizes[i]);
+
+    double start = now_sec();
+    int ret = obj_optimize(&obj);
+    double time = now_sec() - start;
+    if (ret < 0) {
+        fprintf(stderr, "Could not optimize %s\n", filename);
+        obj_cleanup(&obj);
+        return;
+    }
+
+    printf("acmr   %-27s", label);
+    for (int i = 0; i < 3; i++)
+        printf(" %u: %.3f -> %.3f", cache_sizes[i], before[i],
+               obj_acmr(&obj, cache_sizes[i]));
+    printf(" %9.3f ms\n", time * 1000);
+    obj_cleanup(&obj);
+}
+
+#define LOD_GRID 8 // Copies per side of the bench_lod grid
+
+/**
+ * Draws a grid of copies of the mesh receding from the camera, each row
+ * further away, through canvas_draw_mesh and through canvas_draw_lod, and
+ * reports the faces submitted per covered pixel.
+ */
+static void bench_lod(const char *filename) {
+    obj_t obj;
+    if (obj_load(&obj, filename) < 0) {
+        fprintf(stderr, "Could not load %s\n", filename);
+        return;
+    }
+
+    point3_t mesh_center;
+    float scale = mesh_fit(&obj, &mesh_center) / LOD_GRID;
+
+    lod_t lod;
+    double start = now_sec();
+    if (lod_build(&lod, &obj, 64) < 0) {
+        fprintf(stderr, "Could not simplify %s\n", filename);
+        obj_cleanup(&obj);
+        return;
+    }
+    double build_time = now_sec() - start;
+
+    struct camera lod_cam = cam;
+    lod_cam.cull = CULL_CCW;
+    for (int use_lod = 0; use_lod < 2; use_lod++) {
+        size_t faces = 0;
+        uint64_t covered = 0;
+        double raster_time = 0;
+        for (int frame = 0; frame < FRAMES; frame++) {
+            canvas_fill(&canvas, COLOR_BLACK);
+            canvas_depth_reset(&canvas);
+
+            start = now_sec();
+            for (int i = 0; i < LOD_GRID * LOD_GRID; i++) {
+                int row = i / LOD_GRID;
+                int col = i % LOD_GRID;
+                float depth = cam.dist + row * row * 400.f;
+                struct transform model = transform_model(
+                    mesh_center, scale, ANGULAR_STEP * frame + i);
+                model.m[0][3] += ((col + 0.5f) / LOD_GRID - 0.5f) * WIDTH *
+                                 depth / cam.focal_len;
+                model.m[1][3] += ((row + 0.5f) / LOD_GRID - 0.5f) * HEIGHT *
+                                 depth / cam.focal_len;
+                model.m[2][3] += depth - cam.dist;
+
+                size_t level = use_lod ? lod_select(&lod, &model, lod_cam) : 0;
+                faces += obj_face_count(&lod.levels[level]);
+                canvas_draw_mesh(&canvas, &lod.levels[level], &model, lod_cam);
+            }
+            raster_time += now_sec() - start;
+
+            for (uint32_t y = 0; y < canvas.height; y++) {
+                const float *row =
+                    (const float *)canvas.depth + y * canvas.stride;
+                for (uint32_t x = 0; x < canvas.width; x++)
+                    covered += row[x] < FLT_MAX;
+            }
+        }
+
+        printf("%-6s %-27s faces/frame=%-8zu faces/kpx=%-7.1f %7.2f ms/frame",
+               use_lod ? "lod" : "full", filename, faces / FRAMES,
+               (double)faces * 1000 / (double)MAX(covered, 1),
+               raster_time * 1000 / FRAMES);
+        if (use_lod)
+            printf(" (%zu levels built in %.1f ms)", lod.level_count,
+                   build_time * 1000);
+        printf("\n");
+    }
+    lod_cleanup(&lod);
+}
+
+#define DEPTH_NEAR 100.f // The distance storing as 1 in the reversed formats
+
+/**
+ * Draws the mesh with each depth format at growing distances, scaled up to
+ * cover the same pixels, and reports the time, the bytes of depth per pixel
+ * and how many pixels of the first frame differ from DEPTH_F32_REV.
+ */
+static void bench_depth(const char *filename) {
+    static const struct {
+        enum depth_format format;
+        const char *name;
+        uint32_t bytes;
+    } formats[] = {
+        {DEPTH_F32_REV, "f32-rev", 4},
+        {DEPTH_F32, "f32", 4},
+        {DEPTH_UNORM24, "unorm24", 3},
+        {DEPTH_UNORM16, "unorm16", 2},
+    };
+    static const float dists[] = {1000, 10000, 100000};
+
+    obj_t obj;
+    if (obj_load(&obj, filename) < 0) {
+        fprintf(stderr, "Could not load %s\n", filename);
+        return;
+    }
+    size_t size = (size_t)canvas.stride * canvas.height;
+    struct rgba *reference = malloc(size * sizeof(*reference));
+    if (!reference) {
+        obj_cleanup(&obj);
+        return;
+    }
+
+    point3_t mesh_center;
+    float scale = mesh_fit(&obj, &mesh_center);
+    struct camera depth_cam = cam;
+    depth_cam.cull = CULL_CCW;
+    for (size_t d = 0; d < sizeof(dists) / sizeof(*dists); d++) {
+        for (size_t f = 0; f < sizeof(formats) / sizeof(*formats); f++) {
+            canvas_use_depth_format(&canvas, formats[f].format, DEPTH_NEAR);
+            double raster_time = 0;
+            uint64_t differing = 0;
+            for (int frame = 0; frame < FRAMES; frame++) {
+                canvas_fill(&canvas, COLOR_BLACK);
+                canvas_depth_reset(&canvas);
+
+                double start = now_sec();
+                struct transform model = transform_model(
+                    mesh_center, scale * dists[d] / cam.dist,
+                    ANGULAR_STEP * frame);
+                model.m[2][3] += dists[d] - cam.dist;
+                canvas_draw_mesh(&canvas, &obj, &model, depth_cam);
+                raster_time += now_sec() - start;
+
+                if (frame > 0)
+                    continue;
+                if (f == 0) {
+                    memcpy(reference, canvas.data, size * sizeof(*reference));
+                    continue;
+                }
+                for (size_t px = 0; px < size; px++)
+                    differing += memcmp(&reference[px], &canvas.data[px],
+                                        sizeof(*reference)) != 0;
+            }
+
+            printf("depth  %-8s dist=%-7.0f %7.2f ms/frame %u B/px "
+                   "%7.1f MB %8" PRIu64 " px differ\n",
+                   formats[f].name, dists[d], raster_time * 1000 / FRAMES,
+                   formats[f].bytes,
+                   (double)(size * formats[f].bytes) / (1 << 20), differing);
+        }
+    }
+
+    canvas_use_depth(&canvas);
+    free(reference);
+    obj_cleanup(&obj);
+}
+
+static void bench_file(const char *filename) {
+    binner_t binner;
+    binner_init(&binner, &canvas, 0);
+
+    bench_mesh(filename, NULL, CULL_NONE, false);
+    bench_mesh(filename, &binner, CULL_NONE, false);
+
+    // OBJ front faces wind clockwise on the canvas
+    bench_mesh(filename, NULL, CULL_CCW, false);
+    bench_mesh(filename, &binner, CULL_CCW, false);
+    bench_mesh(filename, NULL, CULL_CCW, true);
+    bench_mesh(filename, &binner, CULL_CCW, true);
+
+    binner_cleanup(&binner);
+}
+
+#define SCRATCH_LAYERS 8
+#define SCRATCH_SIZE 200
+
+static void scratch_layers_frame(canvas_pool_t *const pool,
+                                 const struct allocator *const alloc) {
+    for (int i = 0; i < SCRATCH_LAYERS; i++) {
+        canvas_t layer;
+        if (pool)
+            canvas_pool_acquire(pool, &layer, SCRATCH_SIZE, SCRATCH_SIZE,
+                                C(0x80FF8040));
+        else
+            canvas_init_with(&layer, SCRATCH_SIZE, SCRATCH_SIZE,
+                             C(0x80FF8040), alloc);
+        canvas_fill_circle(&layer, SCRATCH_SIZE / 2, SCRATCH_SIZE / 2,
+                           SCRATCH_SIZE / 3, C(0xFF3C8CF0));
+        canvas_blend_canvas(&canvas, &layer, i * SCRATCH_SIZE / 2,
+                            i * SCRATCH_SIZE / 2);
+        if (pool)
+            canvas_pool_release(pool, &layer);
+        else
+            canvas_cleanup(&layer);
+    }
+}
+
+/**
+ * Draws and blends SCRATCH_LAYERS temporary layer canvases per frame, made
+ * with canvas_init, taken from a canvas pool, or carved out of a frame arena,
+ * and reports the time and heap allocations per frame after the first.
+ */
+static void bench_scratch_layers(void) {
+    int reps = FRAMES * 10;
+    canvas_pool_t pool;
+    canvas_pool_init(&pool, NULL);
+    arena_t arena;
+    arena_init(&arena, SCRATCH_SIZE * SCRATCH_SIZE * sizeof(struct rgba) *
+                           SCRATCH_LAYERS * 2);
+    struct allocator frame_alloc = arena_allocator(&arena);
+
+    const char *names[] = {"canvas_init", "canvas_pool", "arena"};
+    for (int mode = 0; mode < 3; mode++) {
+        double time = 0;
+        uint64_t allocs = 0;
+        for (int i = 0; i < reps; i++) {
+            if (i == 1)
+                allocs = heap_alloc_count();
+            double start = now_sec();
+            arena_reset(&arena);
+            scratch_layers_frame(mode == 1 ? &pool : NULL,
+                                 mode == 2 ? &frame_alloc : NULL);
+            time += now_sec() - start;
+        }
+        allocs = heap_alloc_count() - allocs;
+        printf("layers %-12s %7.3f ms/frame %6.1f heap allocations/frame\n",
+               names[mode], time * 1000 / reps, (double)allocs / (reps - 1));
+    }
+
+    arena_cleanup(&arena);
+    canvas_pool_cleanup(&pool);
+}
+
+int main(int argc, char **argv) {
+    canvas_init(&canvas, WIDTH, HEIGHT, COLOR_BLACK);
+    canvas_use_depth(&canvas);
+
+    bench_clear();
+    bench_fast_clear();
+    bench_dirty();
+    bench_blend();
+    bench_circles();
+    bench_cmd_buffer();
+    bench_text();
+    bench_scratch_layers();
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++)
+            bench_load(argv[i], argv[i]);
+        for (int i = 1; i < argc; i++)
+            bench_optimize(argv[i], argv[i]);
+        for (int i = 1; i < argc; i++)
+            bench_lod(argv[i]);
+        for (int i = 1; i < argc; i++)
+            bench_file(argv[i]);
+    } else {
+        bench_load("vendor/cow.obj", "vendor/cow.obj");
+        bench_load("vendor/teapot.obj", "vendor/teapot.obj");
+        bench_load("vendor/teddybear.obj", "vendor/teddybear.obj");
+        bench_load("vendor/pumpkin.obj", "vendor/pumpkin.obj");
+        bench_load_synthetic(1000);
+
+        bench_optimize("vendor/cow.obj", "vendor/cow.obj");
+        bench_optimize("vendor/teapot.obj", "vendor/teapot.obj");
+        bench_optimize("vendor/teddybear.obj", "vendor/teddybear.obj");
+        bench_optimize("vendor/pumpkin.obj", "vendor/pumpkin.obj");
+
+        bench_lod("vendor/cow.obj");
+        bench_lod("vendor/teapot.obj");
+        bench_lod("vendor/teddybear.obj");
+        bench_lod("vendor/pumpkin.obj");
+
+        bench_depth("vendor/teapot.obj");
+
+        bench_file("vendor/cow.obj");
+        bench_file("vendor/teapot.obj");
+        bench_file("vendor/teddybear.obj");
+        bench_file("vendor/pumpkin.obj");
+    }
+
+    canvas_cleanup(&canvas);
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include "../vendor/raylib-5.5_macos/include/raylib.h"
 #include "font_mojangles.h"
 #include "moluvi.h"
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdio.h>
 
@@ -15,6 +16,7 @@ static struct camera cam = {
     .focal_len = 1000,
     .width = WIDTH,
     .height = HEIGHT,
+    .cull = CULL_CCW, // OBJ front faces wind clockwise on the canvas
 };
 
 void points_example(canvas_t *const canvas, double dt) {
@@ -22,7 +24,7 @@ void points_example(canvas_t *const canvas, double dt) {
     uint32_t x_interval = WIDTH / 10;
     uint32_t y_interval = HEIGHT / 10;
 
-    canvas_fill(canvas, COLOR_BLACK);
+    canvas_clear(canvas, COLOR_BLACK);
 
     point3_t center = {0, 0, cam.dist};
     for (uint32_t x = x_interval / 2; x < canvas->width; x += x_interval) {
@@ -54,25 +56,102 @@ void points_example(canvas_t *const canvas, double dt) {
 }
 
 #define WORLD_SCALE 60
-void obj_example(canvas_t *const canvas, obj_t teapot, double dt) {
+void obj_example(canvas_t *const canvas, binner_t *const binner, obj_t teapot,
+                 double dt) {
     static point3_t center = {0, 0, 0};
 
-    canvas_fill(canvas, COLOR_BLACK);
-    canvas_depth_reset(canvas);
-    for (size_t i = 0; i < obj_face_count(&teapot); i++) {
-        struct vec3z face = obj_get_face(&teapot, i);
+    canvas_clear(canvas, COLOR_BLACK);
 
-        point3_t vertices[3] = {
-            obj_get_vertex(&teapot, face.x, WORLD_SCALE),
-            obj_get_vertex(&teapot, face.y, WORLD_SCALE),
-            obj_get_vertex(&teapot, face.z, WORLD_SCALE),
-        };
+    struct transform model =
+        transform_model(center, WORLD_SCALE, ANGULAR_SPEED * dt);
+    binner_draw_mesh(binner, &teapot, &model, cam);
+    binner_flush(binner);
+}
 
-        for (int i = 0; i < 3; i++) {
-            point3_rotate(&vertices[i], center, ANGULAR_SPEED * dt);
-        }
+#define HUD_WIDTH 260
+#define HUD_HEIGHT 36
+
+/**
+ * Blends a panel showing how many heap allocations the library made in the
+ * last frame, which should be none once the bins have grown to fit. The panel
+ * is a throwaway canvas carved out of the frame arena; its text comes from
+ * text, which keeps it across frames.
+ */
+void hud_example(canvas_t *const canvas, const struct allocator *const alloc,
+                 text_cache_t *const text, uint64_t heap_allocs) {
+    canvas_t hud;
+    int ret = canvas_init_with(&hud, HUD_WIDTH, HUD_HEIGHT, C(0x80000000),
+                               alloc);
+    if (ret < 0)
+        return;
+
+    char label[32];
+    snprintf(label, sizeof(label), "ALLOCS %" PRIu64, heap_allocs);
+    canvas_write_string_cached(&hud, text, label, 10, 10, font_mojangles, 2,
+                               COLOR_WHITE);
+    canvas_blend_canvas(canvas, &hud, 20, 20);
+    canvas_cleanup(&hud);
+}
+
+// Frames in flight between the render thread and the window. SWAP_FIFO paces
+// rendering to the display; SWAP_LATEST renders flat out and shows the newest.
+#define SWAP_BUFFERS 3
+#define SWAP_POLICY SWAP_FIFO
+
+struct renderer {
+    swap_chain_t chain;
+    binner_t binner;
+    obj_t teapot;
 
-        canvas_proj_tri(canvas, vertices, cam);
+    // Per-frame scratch, released all at once at the start of every frame
+    arena_t arena;
+    struct allocator frame_alloc;
+
+    // Pre-rendered HUD strings, kept from frame to frame
+    text_cache_t text;
+};
+
+/**
+ * Draws frames into the swap chain until it is closed, while the main thread
+ * uploads and shows the previous one.
+ */
+static void *render_thread(void *arg) {
+    struct renderer *r = arg;
+    uint64_t heap_allocs = 0;
+    canvas_t *canvas;
+    while ((canvas = swap_chain_acquire(&r->chain, NULL))) {
+        uint64_t frame_start = heap_alloc_count();
+        arena_reset(&r->arena);
+        canvas_dirty_reset(canvas);
+
+        binner_set_canvas(&r->binner, canvas);
+        // points_example(canvas, GetTime());
+        obj_example(canvas, &r->binner, r->teapot, GetTime());
+        hud_example(canvas, &r->frame_alloc, &r->text, heap_allocs);
+        heap_allocs = heap_alloc_count() - frame_start;
+
+        swap_chain_submit(&r->chain, canvas);
+    }
+    return NULL;
+}
+
+/**
+ * Uploads the rectangles of canvas in rects to texture. UpdateTextureRec
+ * takes rows without padding, so each rectangle is packed into scratch first.
+ */
+static void upload_rects(Texture2D texture, const canvas_t *const canvas,
+                         const arraylist_t *const rects,
+                         struct rgba *const scratch) {
+    const struct dirty_rect *r = rects->data;
+    for (size_t i = 0; i < rects->count; i++) {
+        for (uint32_t y = 0; y < r[i].height; y++)
+            memcpy(&scratch[(size_t)y * r[i].width],
+                   &canvas->data[(size_t)(r[i].y + y) * canvas->stride +
+                                 r[i].x],
+                   r[i].width * sizeof(struct rgba));
+        UpdateTextureRec(texture,
+                         (Rectangle){r[i].x, r[i].y, r[i].width, r[i].height},
+                         scratch);
     }
 }
 
@@ -81,41 +160,99 @@ int main() {
     int ret;
     InitWindow(WIDTH, HEIGHT, "Moluvi Examples");
 
-    canvas_t canvas;
-    canvas_init(&canvas, WIDTH, HEIGHT, COLOR_WHITE);
-    canvas_use_depth(&canvas);
+    static struct renderer r;
+    ret = swap_chain_init(&r.chain, WIDTH, HEIGHT, SWAP_BUFFERS, SWAP_POLICY);
+    if (ret < 0)
+        return ret;
+    for (uint32_t i = 0; i < SWAP_BUFFERS; i++) {
+        canvas_use_depth(&r.chain.buffers[i]);
+        canvas_track_dirty(&r.chain.buffers[i]);
+    }
 
-    obj_t teapot;
-    ret = obj_load(&teapot, "vendor/cow.obj");
+    ret = binner_init(&r.binner, &r.chain.buffers[0], 0);
+    if (ret < 0)
+        return ret;
+
+    ret = obj_load_cached(&r.teapot, "vendor/cow.obj");
+    if (ret < 0)
+        return ret;
+
+    ret = arena_init(&r.arena, 1 << 20);
     if (ret < 0)
         return ret;
-    // points_example(&canvas, 0);
+    r.frame_alloc = arena_allocator(&r.arena);
 
-    obj_example(&canvas, teapot, GetTime());
-    Image img = (Image){.data = canvas.data,
-                        .width = WIDTH,
+    ret = text_cache_init(&r.text, 64 << 10);
+    if (ret < 0)
+        return ret;
+
+    // Rows are padded to canvas.stride, which the texture keeps
+    canvas_t *first = &r.chain.buffers[0];
+    Image img = (Image){.data = first->data,
+                        .width = first->stride,
                         .height = HEIGHT,
                         .mipmaps = 1,
                         .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
     Texture2D texture = LoadTextureFromImage(img);
 
+    // Dirty rectangles of the frame being shown and of the one shown before
+    arraylist_t dirty, shown;
+    ARRAY_MAKE(&dirty, struct dirty_rect, 64);
+    ARRAY_MAKE(&shown, struct dirty_rect, 64);
+    struct rgba *scratch = malloc((size_t)WIDTH * HEIGHT * sizeof(struct rgba));
+    if (!scratch)
+        return -1;
+
+    pthread_t renderer;
+    if (pthread_create(&renderer, NULL, &render_thread, &r) != 0)
+        return -1;
+
     SetTargetFPS(60);
 
+    // The window's graphics context belongs to this thread, so frames are
+    // presented here rather than with swap_chain_present_async
     while (!WindowShouldClose()) {
-        // points_example(&canvas, GetTime());
-        obj_example(&canvas, teapot, GetTime());
-        UpdateTexture(texture, canvas.data);
+        uint64_t frame;
+        canvas_t *canvas = swap_chain_next(&r.chain, &frame);
+        if (!canvas)
+            break;
+        // Every frame starts with canvas_clear, so whatever a frame left
+        // alone shows the background in every buffer. The texture holds the
+        // frame shown last, and differs only where that one or this one drew.
+        if (canvas_dirty_rects(canvas, &dirty) < 0) {
+            // Out of memory for the rectangles: upload the whole frame, and
+            // again with the next one
+            dirty.count = 1;
+            *(struct dirty_rect *)dirty.data =
+                (struct dirty_rect){0, 0, WIDTH, HEIGHT};
+        }
+        upload_rects(texture, canvas, &dirty, scratch);
+        upload_rects(texture, canvas, &shown, scratch);
+        swap_chain_release(&r.chain, canvas);
+        SWAP(arraylist_t, dirty, shown);
 
         BeginDrawing();
         ClearBackground(RAYWHITE);
-        DrawTexture(texture, 0, 0, WHITE);
+        DrawTextureRec(texture, (Rectangle){0, 0, WIDTH, HEIGHT},
+                       (Vector2){0, 0}, WHITE);
         EndDrawing();
     }
 
+    // Wakes the renderer if it waits for a buffer
+    swap_chain_close(&r.chain);
+    pthread_join(renderer, NULL);
+
     UnloadTexture(texture);
     CloseWindow();
 
-    obj_cleanup(&teapot);
-    canvas_cleanup(&canvas);
+    free(scratch);
+    array_cleanup(&dirty);
+    array_cleanup(&shown);
+
+    text_cache_cleanup(&r.text);
+    arena_cleanup(&r.arena);
+    obj_cleanup(&r.teapot);
+    binner_cleanup(&r.binner);
+    swap_chain_cleanup(&r.chain);
     return ret;
 }
@@ -8,540 +8,648 @@
 
 #define MJ_GLYPH_WIDTH 8
 #define MJ_GLYPH_HEIGHT 8
-#define MJ_GLYPH_SIZE (MJ_GLYPH_WIDTH * MJ_GLYPH_HEIGHT)
+
+// Packs a glyph row into a byte, its leftmost pixel in the lowest bit, and
+// eight rows into a glyph, the top row in the lowest byte
+#define MJ_ROW(a, b, c, d, e, f, g, h)                                         \
+    ((uint64_t)((a) | (b) << 1 | (c) << 2 | (d) << 3 | (e) << 4 | (f) << 5 |   \
+                (g) << 6 | (h) << 7))
+#define MJ_GLYPH(r0, r1, r2, r3, r4, r5, r6, r7)                               \
+    ((r0) | (r1) << 8 | (r2) << 16 | (r3) << 24 | (r4) << 32 | (r5) << 40 |    \
+     (r6) << 48 | (r7) << 56)
 
 // clang-format off
-const char glyphs_mojangles[128][MJ_GLYPH_SIZE] = {
-    [' '] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['A'] = {
-        0,0,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,1,1,1,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['B'] = {
-        0,1,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['C'] = {
-        0,0,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['D'] = {
-        0,1,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['E'] = {
-        0,1,1,1,1,1,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,1,1,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,1,1,1,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['F'] = {
-        0,1,1,1,1,1,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,1,1,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['G'] = {
-        0,0,1,1,1,1,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,1,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['H'] = {
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,1,1,1,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['I'] = {
-        0,1,1,1,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,1,1,1,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['J'] = {
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['K'] = {
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,1,0,0,0,
-        0,1,1,1,0,0,0,0,
-        0,1,0,0,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['L'] = {
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,1,1,1,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['M'] = {
-        0,1,0,0,0,1,0,0,
-        0,1,1,0,1,1,0,0,
-        0,1,0,1,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['N'] = {
-        0,1,0,0,0,1,0,0,
-        0,1,1,0,0,1,0,0,
-        0,1,0,1,0,1,0,0,
-        0,1,0,0,1,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['O'] = {
-        0,0,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['P'] = {
-        0,1,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,1,1,1,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['Q'] = {
-        0,0,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,1,0,0,0,
-        0,0,1,1,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['R'] = {
-        0,1,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['S'] = {
-        0,0,1,1,1,1,0,0,
-        0,1,0,0,0,0,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['T'] = {
-        0,1,1,1,1,1,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['U'] = {
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['V'] = {
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,0,1,0,0,0,
-        0,0,1,0,1,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['W'] = {
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,1,0,1,0,0,
-        0,1,1,0,1,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['X'] = {
-        0,1,0,0,0,1,0,0,
-        0,0,1,0,1,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,1,0,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['Y'] = {
-        0,1,0,0,0,1,0,0,
-        0,0,1,0,1,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['Z'] = {
-        0,1,1,1,1,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,1,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,1,1,1,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['a'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,1,0,0,
-        0,0,1,1,1,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['b'] = {
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,1,1,0,0,0,
-        0,1,1,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['c'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['d'] = {
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,0,1,1,0,1,0,0,
-        0,1,0,0,1,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['e'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,1,1,1,1,0,0,
-        0,1,0,0,0,0,0,0,
-        0,0,1,1,1,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['f'] = {
-        0,0,0,1,1,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,1,1,1,1,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['g'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,1,1,1,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,1,1,1,1,0,0,0,
-    },
-    ['h'] = {
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,1,1,0,0,0,
-        0,1,1,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['i'] = {
-        0,0,1,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['j'] = {
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['k'] = {
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,1,0,0,0,
-        0,1,0,1,0,0,0,0,
-        0,1,1,0,0,0,0,0,
-        0,1,0,1,0,0,0,0,
-        0,1,0,0,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['l'] = {
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['m'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,1,1,0,1,0,0,0,
-        0,1,0,1,0,1,0,0,
-        0,1,0,1,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['n'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,1,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['o'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,1,1,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['p'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,1,0,1,1,0,0,0,
-        0,1,1,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,1,1,1,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-    },
-    ['q'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,1,1,0,1,0,0,
-        0,1,0,0,1,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,0,0,0,0,1,0,0,
-    },
-    ['r'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,1,0,1,1,0,0,0,
-        0,1,1,0,0,1,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,1,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['s'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,0,1,1,1,1,0,0,
-        0,1,0,0,0,0,0,0,
-        0,0,1,1,1,0,0,0,
-        0,0,0,0,0,1,0,0,
-        0,1,1,1,1,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['t'] = {
-        0,0,1,0,0,0,0,0,
-        0,1,1,1,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['u'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['v'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,0,1,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['w'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,1,0,1,0,0,
-        0,1,0,1,0,1,0,0,
-        0,0,1,1,1,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['x'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,0,1,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,1,0,1,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
-    ['y'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,1,0,0,0,1,0,0,
-        0,0,1,1,1,1,0,0,
-        0,0,0,0,0,1,0,0,
-        0,1,1,1,1,0,0,0,
-    },
-    ['z'] = {
-        0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,
-        0,1,1,1,1,1,0,0,
-        0,0,0,0,1,0,0,0,
-        0,0,0,1,0,0,0,0,
-        0,0,1,0,0,0,0,0,
-        0,1,1,1,1,1,0,0,
-        0,0,0,0,0,0,0,0,
-    },
+const uint64_t glyphs_mojangles[128] = {
+    [' '] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['0'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,1,1,0,0),
+        MJ_ROW(0,1,0,1,0,1,0,0),
+        MJ_ROW(0,1,1,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['1'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,1,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['2'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,1,1,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['3'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['4'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,1,0,0,0),
+        MJ_ROW(0,0,0,1,1,0,0,0),
+        MJ_ROW(0,0,1,0,1,0,0,0),
+        MJ_ROW(0,1,0,0,1,0,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,1,0,0,0),
+        MJ_ROW(0,0,0,0,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['5'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['6'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,1,1,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['7'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,1,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['8'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['9'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,1,0,0,0),
+        MJ_ROW(0,0,1,1,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['A'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['B'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['C'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['D'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['E'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['F'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['G'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['H'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['I'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['J'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['K'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,1,0,0,0),
+        MJ_ROW(0,1,1,1,0,0,0,0),
+        MJ_ROW(0,1,0,0,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['L'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['M'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,0,1,1,0,0),
+        MJ_ROW(0,1,0,1,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['N'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,0,0,1,0,0),
+        MJ_ROW(0,1,0,1,0,1,0,0),
+        MJ_ROW(0,1,0,0,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['O'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['P'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['Q'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,1,0,0,0),
+        MJ_ROW(0,0,1,1,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['R'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['S'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['T'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['U'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['V'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,0,1,0,0,0),
+        MJ_ROW(0,0,1,0,1,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['W'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,1,0,1,0,0),
+        MJ_ROW(0,1,1,0,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['X'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,0,1,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,1,0,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['Y'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,0,1,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['Z'] = MJ_GLYPH(
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,1,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['a'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['b'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,1,1,0,0,0),
+        MJ_ROW(0,1,1,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['c'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['d'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,0,1,0,0),
+        MJ_ROW(0,1,0,0,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['e'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['f'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,1,1,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['g'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0)
+    ),
+    ['h'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,1,1,0,0,0),
+        MJ_ROW(0,1,1,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['i'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['j'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['k'] = MJ_GLYPH(
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,1,0,0,0),
+        MJ_ROW(0,1,0,1,0,0,0,0),
+        MJ_ROW(0,1,1,0,0,0,0,0),
+        MJ_ROW(0,1,0,1,0,0,0,0),
+        MJ_ROW(0,1,0,0,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['l'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['m'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,0,1,0,0,0),
+        MJ_ROW(0,1,0,1,0,1,0,0),
+        MJ_ROW(0,1,0,1,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['n'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['o'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['p'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,1,1,0,0,0),
+        MJ_ROW(0,1,1,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0)
+    ),
+    ['q'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,1,0,1,0,0),
+        MJ_ROW(0,1,0,0,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0)
+    ),
+    ['r'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,1,1,0,0,0),
+        MJ_ROW(0,1,1,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['s'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,1,0,0,0,0,0,0),
+        MJ_ROW(0,0,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['t'] = MJ_GLYPH(
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['u'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['v'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,0,1,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['w'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,1,0,1,0,0),
+        MJ_ROW(0,1,0,1,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['x'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,0,1,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,1,0,1,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
+    ['y'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,1,0,0,0,1,0,0),
+        MJ_ROW(0,0,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,1,0,0),
+        MJ_ROW(0,1,1,1,1,0,0,0)
+    ),
+    ['z'] = MJ_GLYPH(
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,1,0,0,0),
+        MJ_ROW(0,0,0,1,0,0,0,0),
+        MJ_ROW(0,0,1,0,0,0,0,0),
+        MJ_ROW(0,1,1,1,1,1,0,0),
+        MJ_ROW(0,0,0,0,0,0,0,0)
+    ),
 
 };
 // clang-format on
@@ -549,7 +657,7 @@ const char glyphs_mojangles[128][MJ_GLYPH_SIZE] = {
 static font_t font_mojangles = {
     .glyph_width = MJ_GLYPH_WIDTH,
     .glyph_height = MJ_GLYPH_HEIGHT,
-    .glyphs = &glyphs_mojangles[0][0],
+    .glyphs = glyphs_mojangles,
 };
 
 #endif // FONT_MOJANGLES
@@ -0,0 +1,52 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "moluvi.h"
+
+/**
+ * Converts OBJ files to mesh caches, written next to each file as
+ * <file>.mesh, where obj_load_cached picks them up. With -O, the meshes are
+ * run through obj_optimize first.
+ */
+int main(int argc, char **argv) {
+    bool optimize = argc > 1 && strcmp(argv[1], "-O") == 0;
+    int first = optimize ? 2 : 1;
+    if (argc <= first) {
+        fprintf(stderr, "Usage: %s [-O] file.obj [file.obj ...]\n", argv[0]);
+        return 1;
+    }
+
+    int failed = 0;
+    for (int i = first; i < argc; i++) {
+        char cache_path[4096];
+        snprintf(cache_path, sizeof(cache_path), "%s.mesh", argv[i]);
+
+        obj_t obj;
+        int ret = obj_load(&obj, argv[i]);
+        float before = 0, after = 0;
+        if (ret == 0 && optimize) {
+            before = obj_acmr(&obj, 16);
+            ret = obj_optimize(&obj);
+            if (ret < 0)
+                obj_cleanup(&obj);
+            else
+                after = obj_acmr(&obj, 16);
+        }
+        if (ret == 0) {
+            ret = obj_write_cache(&obj, cache_path, argv[i]);
+            obj_cleanup(&obj);
+        }
+
+        if (ret < 0) {
+            fprintf(stderr, "%s: %s\n", argv[i], strerror(-ret));
+            failed = 1;
+        } else if (optimize) {
+            printf("%s -> %s (acmr %.3f -> %.3f)\n", argv[i], cache_path,
+                   before, after);
+        } else {
+            printf("%s -> %s\n", argv[i], cache_path);
+        }
+    }
+    return failed;
+}
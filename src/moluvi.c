@@ -1,13 +1,114 @@
 #include "moluvi.h"
 #include <errno.h>
+#include <fcntl.h>
 #include <float.h>
 #include <math.h>
+#include <pthread.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
+
+// Pixel runs and blocks are processed with the GCC/Clang vector extensions,
+// which map to AVX2 (8 lanes), SSE2 or NEON (4 lanes). Define MOLUVI_NO_SIMD,
+// or use another compiler, for the scalar paths.
+#if !defined(MOLUVI_NO_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#if defined(__AVX2__)
+#define SIMD_LANES 8
+#else
+#define SIMD_LANES 4
+#endif
+#else
+#define SIMD_LANES 1
+#endif
+
+#if SIMD_LANES > 1
+typedef int32_t vi32 __attribute__((vector_size(SIMD_LANES * 4)));
+typedef uint32_t vu32 __attribute__((vector_size(SIMD_LANES * 4)));
+typedef float vf32 __attribute__((vector_size(SIMD_LANES * 4)));
+typedef double vf64 __attribute__((vector_size(SIMD_LANES * 8)));
+#endif
+
+/**
+ * Heap allocations
+ *
+ * Every allocation the library makes from the C heap goes through these, so
+ * heap_alloc_count can tell whether a frame allocated at all.
+ */
+
+static uint64_t heap_allocs;
+
+static inline void heap_count(void) {
+    __atomic_fetch_add(&heap_allocs, 1, __ATOMIC_RELAXED);
+}
+
+static void *heap_malloc(size_t size) {
+    heap_count();
+    return malloc(size);
+}
+
+static void *heap_calloc(size_t count, size_t size) {
+    heap_count();
+    return calloc(count, size);
+}
+
+static void *heap_realloc(void *ptr, size_t size) {
+    heap_count();
+    return realloc(ptr, size);
+}
+
+static void *heap_aligned_alloc(size_t align, size_t size) {
+    heap_count();
+    return aligned_alloc(align, size);
+}
+
+/**
+ * Returns the number of heap allocations, reallocations and anonymous
+ * mappings the library has made so far, from any thread.
+ */
+uint64_t heap_alloc_count(void) {
+    return __atomic_load_n(&heap_allocs, __ATOMIC_RELAXED);
+}
+
+/**
+ * Allocates size bytes aligned to align from alloc, or from the heap when
+ * alloc is NULL.
+ */
+static void *mem_alloc(const struct allocator *const alloc, size_t size,
+                       size_t align) {
+    if (alloc)
+        return alloc->alloc(alloc->ctx, size, align);
+    return heap_aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+static void mem_free(const struct allocator *const alloc, void *ptr) {
+    if (!ptr)
+        return;
+    if (!alloc)
+        free(ptr);
+    else if (alloc->free)
+        alloc->free(alloc->ctx, ptr);
+}
+
+/**
+ * Appends the item_size bytes at item to arr like ARRAY_APPEND, but returns
+ * -ENOMEM and leaves arr as it was when it cannot grow.
+ */
+static int array_push(arraylist_t *const arr, const void *item,
+                      size_t item_size) {
+    if (arr->count >= arr->capacity) {
+        int ret = array_resize(arr, arr->capacity * 2, item_size);
+        if (ret < 0)
+            return ret;
+    }
+    memcpy(arr->data + arr->count++ * item_size, item, item_size);
+    return 0;
+}
 
 void point3_rotate(point3_t *point, point3_t center, float theta) {
     double sin_theta = sinf(theta);
@@ -19,13 +120,62 @@ void point3_rotate(point3_t *point, point3_t center, float theta) {
     point->z = offset.x * sin_theta + offset.z * cos_theta + center.z;
 }
 
-point2_t point3_proj(point3_t point, struct camera cam) {
+static inline void point3_proj_xy(point3_t point, struct camera cam,
+                                  double *x, double *y) {
     float z_depth = point.z + cam.dist;
-    return (point2_t){
-        (point.x * cam.focal_len) / z_depth + (float)cam.width / 2.,
-        // Invert y as our 2D coordinate system has positive y
-        // pointing down
-        (-point.y * cam.focal_len) / z_depth + (float)cam.height / 2.};
+    *x = (point.x * cam.focal_len) / z_depth + (float)cam.width / 2.;
+    // Invert y as our 2D coordinate system has positive y
+    // pointing down
+    *y = (-point.y * cam.focal_len) / z_depth + (float)cam.height / 2.;
+}
+
+point2_t point3_proj(point3_t point, struct camera cam) {
+    double x, y;
+    point3_proj_xy(point, cam, &x, &y);
+    return (point2_t){x, y};
+}
+
+/**
+ * Sub-pixel positions
+ *
+ * The rasterizer takes vertices in 28.4 fixed point, SUBPIXEL_BITS bits below
+ * the pixel. Pixel (x, y) is sampled at exactly (x, y), so integer vertices
+ * rasterize as they always did, while projected vertices keep their fraction
+ * instead of snapping to whole pixels and jittering as they move.
+ */
+
+#define SUBPIXEL_BITS 4
+#define SUBPIXEL_ONE (1 << SUBPIXEL_BITS)
+
+struct vec2fx {
+    int32_t x;
+    int32_t y;
+};
+
+static inline struct vec2fx vec2fx_from_px(point2_t p) {
+    return (struct vec2fx){(int32_t)(p.x * SUBPIXEL_ONE),
+                           (int32_t)(p.y * SUBPIXEL_ONE)};
+}
+
+static inline int32_t fx_from_double(double v) {
+    return (int32_t)lrint(v * SUBPIXEL_ONE);
+}
+
+// The first pixel sampled at or after v
+static inline int64_t fx_ceil_px(int32_t v) {
+    return ((int64_t)v + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS;
+}
+
+// The last pixel sampled at or before v
+static inline int64_t fx_floor_px(int32_t v) {
+    return (int64_t)v >> SUBPIXEL_BITS;
+}
+
+static inline struct vec2fx point3_proj_fx(point3_t point,
+                                           struct camera cam) {
+    double x, y;
+    point3_proj_xy(point, cam, &x, &y);
+    return (struct vec2fx){fx_from_double(x), fx_from_double(y)};
 }
 
 inline float scale_z(float val, float z, struct camera cam) {
@@ -82,53 +232,555 @@ bool rgba_eql(struct rgba c1, struct rgba c2) {
     return c1.r == c2.r && c1.g == c2.g && c1.b == c2.b && c1.a == c2.a;
 }
 
+/**
+ * Spans
+ *
+ * A span is a horizontal run of pixels in one row. Primitives clip against the
+ * canvas once and then hand whole runs to span_set/span_blend, which neither
+ * bounds-check nor go through canvas_set_px.
+ */
+
+static void span_set(struct rgba *px, size_t n, struct rgba color) {
+    size_t i = 0;
+#if SIMD_LANES > 1
+    vi32 block = (vi32){0} + (int32_t)rgba_to_hex(color);
+    for (; i + SIMD_LANES <= n; i += SIMD_LANES)
+        memcpy(&px[i], &block, sizeof(block));
+#endif
+    for (; i < n; i++)
+        px[i] = color;
+}
+
+/**
+ * Blending
+ *
+ * Lanes hold whole pixels as 0xAABBGGRR. Red and blue are blended together in
+ * the two 16-bit halves of a lane, green on its own, and the division by 255
+ * uses an exact shift-and-add form. Results match rgba_alpha_blend bit for
+ * bit, including the opaque output alpha.
+ */
+
+#if SIMD_LANES > 1
+// Exact x / 255 for both 16-bit halves of x, each at most 65534.
+static inline vu32 lanes_div255(vu32 x) {
+    return ((x + 0x00010001 + ((x >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+}
+
+// Blends src over dst with the per-lane alpha of src.
+static inline vu32 lanes_blend(vu32 src, vu32 dst) {
+    vu32 a = src >> 24;
+    vu32 inv_a = 255 - a;
+    vu32 rb = (src & 0x00FF00FF) * a + (dst & 0x00FF00FF) * inv_a;
+    vu32 g = ((src >> 8) & 0xFF) * a + ((dst >> 8) & 0xFF) * inv_a;
+    return lanes_div255(rb) | lanes_div255(g) << 8 | 0xFF000000;
+}
+
+// Blends a single color over dst, with the color's share premultiplied.
+struct lanes_color {
+    vu32 rb;    // (r, b) * a
+    vu32 g;     // g * a
+    vu32 inv_a; // 255 - a
+};
+
+static inline struct lanes_color lanes_color_init(struct rgba color) {
+    vu32 zero = {0};
+    return (struct lanes_color){
+        .rb = zero + (uint32_t)(color.r | color.b << 16) * color.a,
+        .g = zero + (uint32_t)color.g * color.a,
+        .inv_a = zero + (uint32_t)(255 - color.a),
+    };
+}
+
+static inline vu32 lanes_blend_color(const struct lanes_color *const c,
+                                     vu32 dst) {
+    vu32 rb = c->rb + (dst & 0x00FF00FF) * c->inv_a;
+    vu32 g = c->g + ((dst >> 8) & 0xFF) * c->inv_a;
+    return lanes_div255(rb) | lanes_div255(g) << 8 | 0xFF000000;
+}
+#endif
+
+static void span_blend(struct rgba *px, size_t n, struct rgba color) {
+    if (color.a == 0xFF) {
+        span_set(px, n, color);
+        return;
+    }
+
+    size_t i = 0;
+#if SIMD_LANES > 1
+    if (color.a == 0) {
+        // Only the output alpha changes
+        for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+            vu32 dst;
+            memcpy(&dst, &px[i], sizeof(dst));
+            dst |= 0xFF000000;
+            memcpy(&px[i], &dst, sizeof(dst));
+        }
+    } else {
+        struct lanes_color c = lanes_color_init(color);
+        for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+            vu32 dst;
+            memcpy(&dst, &px[i], sizeof(dst));
+            dst = lanes_blend_color(&c, dst);
+            memcpy(&px[i], &dst, sizeof(dst));
+        }
+    }
+#endif
+    for (; i < n; i++)
+        px[i] = rgba_alpha_blend(color, px[i]);
+}
+
+/**
+ * Blends the n pixels of src over dst, as rgba_alpha_blend would one by one.
+ * Runs of fully opaque source pixels are copied and fully transparent ones
+ * leave the destination colors alone. dst and src may not overlap.
+ */
+void rgba_blend_span(struct rgba *dst, const struct rgba *src, size_t n) {
+    size_t i = 0;
+#if SIMD_LANES > 1
+    for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+        vu32 s, d;
+        memcpy(&s, &src[i], sizeof(s));
+
+        uint32_t all = 0xFF, any = 0;
+        for (int j = 0; j < SIMD_LANES; j++) {
+            all &= s[j] >> 24;
+            any |= s[j] >> 24;
+        }
+
+        if (all == 0xFF) {
+            memcpy(&dst[i], &s, sizeof(s));
+            continue;
+        }
+
+        memcpy(&d, &dst[i], sizeof(d));
+        d = any == 0 ? d | 0xFF000000 : lanes_blend(s, d);
+        memcpy(&dst[i], &d, sizeof(d));
+    }
+#endif
+    for (; i < n; i++) {
+        if (src[i].a == 0xFF)
+            dst[i] = src[i];
+        else
+            dst[i] = rgba_alpha_blend(src[i], dst[i]);
+    }
+}
+
+/**
+ * Allocates a CANVAS_ALIGN aligned buffer of bytes for pixel or depth data
+ * from alloc. Heap buffers of at least CANVAS_HUGE_PAGE_MIN bytes are mapped
+ * instead, so they can be backed by huge pages. Free with canvas_buffer_free
+ * and the same size.
+ */
+static void *canvas_buffer_alloc(const struct allocator *const alloc,
+                                 size_t bytes) {
+    bytes = (bytes + CANVAS_ALIGN - 1) / CANVAS_ALIGN * CANVAS_ALIGN;
+    if (!alloc && CANVAS_HUGE_PAGE_MIN > 0 && bytes >= CANVAS_HUGE_PAGE_MIN) {
+        heap_count();
+        void *buf = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buf == MAP_FAILED)
+            return NULL;
+#ifdef MADV_HUGEPAGE
+        madvise(buf, bytes, MADV_HUGEPAGE); // Only a hint, failure is fine
+#endif
+        return buf;
+    }
+    return mem_alloc(alloc, bytes, CANVAS_ALIGN);
+}
+
+static void canvas_buffer_free(const struct allocator *const alloc, void *buf,
+                               size_t bytes) {
+    bytes = (bytes + CANVAS_ALIGN - 1) / CANVAS_ALIGN * CANVAS_ALIGN;
+    if (buf && !alloc && CANVAS_HUGE_PAGE_MIN > 0 &&
+        bytes >= CANVAS_HUGE_PAGE_MIN)
+        munmap(buf, bytes);
+    else
+        mem_free(alloc, buf);
+}
+
+/**
+ * Size in bytes of a buffer of canvas rows with 4 byte pixels.
+ */
+static inline size_t canvas_buffer_size(const canvas_t *const canvas) {
+    return (size_t)canvas->stride * canvas->height * sizeof(struct rgba);
+}
+
+static inline size_t depth_px_size(enum depth_format format) {
+    switch (format) {
+    case DEPTH_UNORM24:
+        return 3;
+    case DEPTH_UNORM16:
+        return 2;
+    default:
+        return sizeof(float);
+    }
+}
+
 int canvas_init(canvas_t *const canvas, uint32_t width, uint32_t height,
                 struct rgba fill) {
-    struct rgba *data = malloc(width * height * sizeof(struct rgba));
-    if (!data)
+    return canvas_init_with(canvas, width, height, fill, NULL);
+}
+
+/**
+ * canvas_init drawing the pixels, and later the depth buffer and scratch
+ * space, from alloc. The canvas must not outlive what alloc hands out.
+ */
+int canvas_init_with(canvas_t *const canvas, uint32_t width, uint32_t height,
+                     struct rgba fill, const struct allocator *const alloc) {
+    if (width > CANVAS_MAX_DIM || height > CANVAS_MAX_DIM)
+        return -EINVAL;
+
+    // Pad rows so every one starts on a CANVAS_ALIGN boundary
+    const uint32_t align_px = CANVAS_ALIGN / sizeof(struct rgba);
+    *canvas = (canvas_t){
+        .width = width,
+        .height = height,
+        .stride = (width + align_px - 1) / align_px * align_px,
+        .mesh_scratch = {.alloc = alloc},
+        .alloc = alloc,
+    };
+    canvas->data = canvas_buffer_alloc(alloc, canvas_buffer_size(canvas));
+    if (!canvas->data)
         return -ENOMEM;
 
-    for (uint32_t i = 0; i < width * height; i++) {
-        data[i] = fill;
-    }
+    span_set(canvas->data, (size_t)canvas->stride * height, fill);
+    return 0;
+}
 
-    canvas->width = width;
-    canvas->height = height;
-    canvas->data = data;
-    canvas->depth = NULL;
+/**
+ * Makes view a canvas onto the rectangle of canvas at (x, y) of width by
+ * height pixels, clipped to canvas. Drawing into the view clips against the
+ * rectangle and writes straight into the pixels, and the depth buffer if any,
+ * of canvas; nothing is copied. The view must not outlive canvas, and
+ * canvas_cleanup only frees its scratch space. Views of views point into the
+ * same buffers. Make views after canvas_use_depth for them to share depth.
+ */
+int canvas_view(canvas_t *const view, canvas_t *const canvas, int64_t x,
+                int64_t y, uint32_t width, uint32_t height) {
+    if (!canvas || !canvas->data)
+        return -EINVAL;
+
+    int64_t x0 = MIN(MAX(x, 0), (int64_t)canvas->width);
+    int64_t y0 = MIN(MAX(y, 0), (int64_t)canvas->height);
+    int64_t x1 = MIN(MAX(x + (int64_t)width, x0), (int64_t)canvas->width);
+    int64_t y1 = MIN(MAX(y + (int64_t)height, y0), (int64_t)canvas->height);
+
+    size_t offset = (size_t)y0 * canvas->stride + x0;
+    size_t depth_size = depth_px_size(canvas->depth_format);
+    canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    *view = (canvas_t){
+        .width = (uint32_t)(x1 - x0),
+        .height = (uint32_t)(y1 - y0),
+        .stride = canvas->stride,
+        .data = canvas->data + offset,
+        .depth = canvas->depth ? (uint8_t *)canvas->depth + offset * depth_size
+                               : NULL,
+        .depth_format = canvas->depth_format,
+        .depth_near = canvas->depth_near,
+        .parent = root,
+        .origin_x = canvas->origin_x + (uint32_t)x0,
+        .origin_y = canvas->origin_y + (uint32_t)y0,
+    };
     return 0;
 }
 
+static inline uint32_t depth_tile_count(uint32_t px) {
+    return (px + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE;
+}
+
+static inline size_t depth_tiles_size(const canvas_t *const canvas) {
+    return (size_t)depth_tile_count(canvas->width) *
+           depth_tile_count(canvas->height) * sizeof(float);
+}
+
+static inline size_t depth_buffer_size(const canvas_t *const canvas) {
+    return (size_t)canvas->stride * canvas->height *
+           depth_px_size(canvas->depth_format);
+}
+
+/**
+ * Gives canvas a DEPTH_F32 depth buffer, or resets the one it already has.
+ */
 int canvas_use_depth(canvas_t *const canvas) {
-    canvas->depth = malloc(canvas->width * canvas->height * sizeof(float));
-    if (!canvas->depth)
+    return canvas_use_depth_format(canvas, DEPTH_F32, 0);
+}
+
+/**
+ * Gives canvas a depth buffer in format, reset to the far plane. The reversed
+ * formats store near / d for a camera distance d, so near is the distance
+ * that stores as 1; anything nearer is clamped to 1 by the unorm formats.
+ * It is ignored by DEPTH_F32. A depth buffer already in format is reused.
+ */
+int canvas_use_depth_format(canvas_t *const canvas, enum depth_format format,
+                            float near) {
+    if (format != DEPTH_F32 && !(near > 0))
+        return -EINVAL;
+    if (canvas->parent && canvas->depth_near != near && format != DEPTH_F32)
+        return -EINVAL; // Views share the depth buffer of their parent
+    if (canvas->depth && canvas->depth_format == format) {
+        canvas->depth_near = near;
+        return canvas_depth_reset(canvas);
+    }
+    if (canvas->parent)
+        return -EINVAL;
+
+    const struct allocator *alloc = canvas->alloc;
+    if (canvas->depth) {
+        canvas_buffer_free(alloc, canvas->depth, depth_buffer_size(canvas));
+        mem_free(alloc, canvas->depth_tiles);
+    }
+
+    canvas->depth_format = format;
+    canvas->depth_near = near;
+    canvas->depth = canvas_buffer_alloc(alloc, depth_buffer_size(canvas));
+    canvas->depth_tiles =
+        mem_alloc(alloc, depth_tiles_size(canvas), CANVAS_ALIGN);
+    if (!canvas->depth || !canvas->depth_tiles) {
+        canvas_buffer_free(alloc, canvas->depth, depth_buffer_size(canvas));
+        mem_free(alloc, canvas->depth_tiles);
+        canvas->depth = NULL;
+        canvas->depth_tiles = NULL;
         return -ENOMEM;
+    }
+    canvas->depth_tiles_x = depth_tile_count(canvas->width);
     canvas_depth_reset(canvas);
     return 0;
 }
 
+/**
+ * Raises every coarse depth tile of root overlapping the rectangle
+ * [x0, x1) x [y0, y1) to the far plane, as its contents may now be farther.
+ */
+static void depth_tiles_reset(canvas_t *const root, uint32_t x0, uint32_t y0,
+                              uint32_t x1, uint32_t y1) {
+    if (!root->depth_tiles || x0 >= x1 || y0 >= y1)
+        return;
+    for (uint32_t ty = y0 / HIZ_TILE_SIZE; ty <= (y1 - 1) / HIZ_TILE_SIZE;
+         ty++) {
+        for (uint32_t tx = x0 / HIZ_TILE_SIZE; tx <= (x1 - 1) / HIZ_TILE_SIZE;
+             tx++)
+            root->depth_tiles[ty * root->depth_tiles_x + tx] = FLT_MAX;
+    }
+}
+
+/**
+ * Sets the depths of the rectangle [x0, x1) x [y0, y1) of canvas to the far
+ * plane. Every row is a copy of the first.
+ */
+static void depth_rect_reset(canvas_t *const canvas, uint32_t x0, uint32_t y0,
+                             uint32_t x1, uint32_t y1) {
+    if (x0 >= x1 || y0 >= y1)
+        return;
+    size_t px_size = depth_px_size(canvas->depth_format);
+    size_t row_size = (x1 - x0) * px_size;
+    uint8_t *first =
+        (uint8_t *)canvas->depth + ((size_t)y0 * canvas->stride + x0) * px_size;
+
+    // Every format but DEPTH_F32 stores the far plane as zero
+    if (canvas->depth_format == DEPTH_F32) {
+        for (uint32_t x = 0; x < x1 - x0; x++)
+            ((float *)first)[x] = FLT_MAX;
+    } else {
+        memset(first, 0, row_size);
+    }
+    for (uint32_t y = y0 + 1; y < y1; y++)
+        memcpy(first + (size_t)(y - y0) * canvas->stride * px_size, first,
+               row_size);
+}
+
+/**
+ * Fast clears. canvas_clear only records a clear color for each
+ * HIZ_TILE_SIZE tile of the root canvas, and whatever writes pixels first
+ * resolves the tiles it touches by writing out their pending clear.
+ * canvas_resolve writes the color of the tiles still pending when a frame is
+ * presented or exported; their depth is never written unless drawn over. A
+ * resolved tile nothing was drawn to since is clean, and clearing it to the
+ * same color again costs nothing.
+ */
+struct clear_tile {
+    struct rgba color; // Color pending, or held by a clean tile
+    uint8_t flags;
+};
+
+#define CLEAR_COLOR 1 // The color is pending
+#define CLEAR_DEPTH 2 // The far plane is pending
+#define CLEAR_CLEAN 4 // Holds color, and was not drawn to since
+
+static inline struct clear_tile *clear_tile_at(const canvas_t *const root,
+                                               uint32_t tx, uint32_t ty) {
+    return &root->clear_tiles[(size_t)ty * depth_tile_count(root->width) + tx];
+}
+
+/**
+ * Marks tile (tx, ty) of root as drawn into, see canvas_track_dirty.
+ */
+static inline void dirty_tile_mark(canvas_t *const root, uint32_t tx,
+                                   uint32_t ty) {
+    root->dirty_tiles[(size_t)ty * depth_tile_count(root->width) + tx] = 1;
+}
+
+/**
+ * Writes out the pending clears of tile (tx, ty) of root among flags.
+ */
+static void clear_tile_write(canvas_t *const root, uint32_t tx, uint32_t ty,
+                             uint8_t flags) {
+    struct clear_tile *tile = clear_tile_at(root, tx, ty);
+    flags &= tile->flags;
+    uint32_t x0 = tx * HIZ_TILE_SIZE;
+    uint32_t y0 = ty * HIZ_TILE_SIZE;
+    uint32_t x1 = MIN(x0 + HIZ_TILE_SIZE, root->width);
+    uint32_t y1 = MIN(y0 + HIZ_TILE_SIZE, root->height);
+    if (flags & CLEAR_COLOR) {
+        for (uint32_t y = y0; y < y1; y++)
+            span_set(&root->data[(size_t)y * root->stride + x0], x1 - x0,
+                     tile->color);
+    }
+    if ((flags & CLEAR_DEPTH) && root->depth)
+        depth_rect_reset(root, x0, y0, x1, y1);
+    tile->flags &= ~flags;
+}
+
+/**
+ * Prepares tile (tx, ty) of root for drawing the buffers in flags, which are
+ * CLEAR_COLOR and CLEAR_DEPTH bits.
+ */
+static inline void clear_tile_touch(canvas_t *const root, uint32_t tx,
+                                    uint32_t ty, uint8_t flags) {
+    struct clear_tile *tile = clear_tile_at(root, tx, ty);
+    if (tile->flags & flags)
+        clear_tile_write(root, tx, ty, flags);
+    if (flags & CLEAR_COLOR)
+        tile->flags &= ~CLEAR_CLEAN;
+}
+
+/**
+ * clear_tile_touch for every tile overlapping the rectangle [x0, x1] x
+ * [y0, y1] of canvas, clipped to it, marking them dirty if flags has
+ * CLEAR_COLOR. With discard, the caller is about to overwrite the whole
+ * rectangle, so the pending clears of the tiles inside it are dropped instead.
+ */
+static void canvas_resolve_rect(canvas_t *const canvas, int64_t x0, int64_t y0,
+                                int64_t x1, int64_t y1, uint8_t flags,
+                                bool discard) {
+    canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    if (!root->clear_tiles && !root->dirty_tiles)
+        return;
+    x0 = MAX(x0, 0) + canvas->origin_x;
+    y0 = MAX(y0, 0) + canvas->origin_y;
+    x1 = MIN(x1, (int64_t)canvas->width - 1) + canvas->origin_x;
+    y1 = MIN(y1, (int64_t)canvas->height - 1) + canvas->origin_y;
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    for (int64_t ty = y0 / HIZ_TILE_SIZE; ty <= y1 / HIZ_TILE_SIZE; ty++) {
+        int64_t tile_y0 = ty * HIZ_TILE_SIZE;
+        int64_t tile_y1 = MIN(tile_y0 + HIZ_TILE_SIZE, root->height) - 1;
+        for (int64_t tx = x0 / HIZ_TILE_SIZE; tx <= x1 / HIZ_TILE_SIZE; tx++) {
+            if (root->dirty_tiles && (flags & CLEAR_COLOR))
+                dirty_tile_mark(root, tx, ty);
+            if (!root->clear_tiles)
+                continue;
+
+            int64_t tile_x0 = tx * HIZ_TILE_SIZE;
+            int64_t tile_x1 = MIN(tile_x0 + HIZ_TILE_SIZE, root->width) - 1;
+            if (discard && tile_x0 >= x0 && tile_x1 <= x1 && tile_y0 >= y0 &&
+                tile_y1 <= y1) {
+                struct clear_tile *tile = clear_tile_at(root, tx, ty);
+                tile->flags &= ~(flags | CLEAR_CLEAN);
+                continue;
+            }
+            clear_tile_touch(root, tx, ty, flags);
+        }
+    }
+}
+
+/**
+ * Returns the pixels of row y of canvas from x on as they are shown, without
+ * resolving pending clears, and stores in n how many it returns, at most
+ * x_end - x. Pixels of a tile whose clear is pending are written to buf as
+ * the clear color; the rest are read in place, running on through every
+ * following tile with nothing pending.
+ */
+static const struct rgba *canvas_shown_span(const canvas_t *const canvas,
+                                            uint32_t x, uint32_t y,
+                                            uint32_t x_end,
+                                            struct rgba buf[HIZ_TILE_SIZE],
+                                            uint32_t *n) {
+    const canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    const struct rgba *px = &canvas->data[(size_t)y * canvas->stride + x];
+    if (!root->clear_tiles) {
+        *n = x_end - x;
+        return px;
+    }
+
+    uint32_t rx = canvas->origin_x + x, rx_end = canvas->origin_x + x_end;
+    uint32_t ty = (canvas->origin_y + y) / HIZ_TILE_SIZE;
+    uint32_t end = MIN((rx / HIZ_TILE_SIZE + 1) * HIZ_TILE_SIZE, rx_end);
+    const struct clear_tile *tile = clear_tile_at(root, rx / HIZ_TILE_SIZE, ty);
+    if (tile->flags & CLEAR_COLOR) {
+        *n = end - rx;
+        span_set(buf, *n, tile->color);
+        return buf;
+    }
+    while (end < rx_end &&
+           !(clear_tile_at(root, end / HIZ_TILE_SIZE, ty)->flags & CLEAR_COLOR))
+        end = MIN(end + HIZ_TILE_SIZE, rx_end);
+    *n = end - rx;
+    return px;
+}
+
 int canvas_depth_reset(canvas_t *const canvas) {
     if (canvas->depth == NULL)
         return -EINVAL;
-    for (uint32_t i = 0; i < canvas->width * canvas->height; i++) {
-        canvas->depth[i] = FLT_MAX;
-    }
+    canvas_resolve_rect(canvas, 0, 0, (int64_t)canvas->width - 1,
+                        (int64_t)canvas->height - 1, CLEAR_DEPTH, true);
+    depth_rect_reset(canvas, 0, 0, canvas->width, canvas->height);
+
+    canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    depth_tiles_reset(root, canvas->origin_x, canvas->origin_y,
+                      canvas->origin_x + canvas->width,
+                      canvas->origin_y + canvas->height);
+    canvas->depth_stats = (struct depth_stats){0};
+    canvas->cull_stats = (struct cull_stats){0};
     return 0;
 }
 
+/**
+ * Returns how much work the coarse depth test saved since the last
+ * canvas_depth_reset.
+ */
+struct depth_stats canvas_depth_stats(const canvas_t *const canvas) {
+    return canvas->depth_stats;
+}
+
+/**
+ * Returns how many triangles canvas_proj_tri and binner_proj_tri culled since
+ * the last canvas_depth_reset.
+ */
+struct cull_stats canvas_cull_stats(const canvas_t *const canvas) {
+    return canvas->cull_stats;
+}
+
 void canvas_cleanup(canvas_t *const canvas) {
     if (!canvas)
         return;
 
-    if (canvas->data) {
-        free(canvas->data);
-        canvas->data = NULL;
+    if (!canvas->parent) {
+        const struct allocator *alloc = canvas->alloc;
+        canvas_buffer_free(alloc, canvas->data, canvas_buffer_size(canvas));
+        canvas_buffer_free(alloc, canvas->depth, depth_buffer_size(canvas));
+        mem_free(alloc, canvas->depth_tiles);
+        mem_free(alloc, canvas->clear_tiles);
+        mem_free(alloc, canvas->dirty_tiles);
     }
+    canvas->data = NULL;
+    canvas->depth = NULL;
+    canvas->depth_tiles = NULL;
+    canvas->clear_tiles = NULL;
+    canvas->dirty_tiles = NULL;
 
-    if (canvas->depth) {
-        free(canvas->depth);
-        canvas->depth = NULL;
-    }
+    array_cleanup(&canvas->mesh_scratch);
+    canvas->mesh_scratch = (arraylist_t){0};
 }
 
 static inline bool canvas_point_in_range(const canvas_t *const canvas,
@@ -144,7 +796,18 @@ int canvas_get_px(const canvas_t *const canvas, uint32_t x, uint32_t y,
                   struct rgba *px) {
     if (!canvas_point_in_range(canvas, x, y))
         return -EDOM;
-    *px = canvas->data[y * canvas->width + x];
+
+    const canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    if (root->clear_tiles) {
+        const struct clear_tile *tile =
+            clear_tile_at(root, (canvas->origin_x + x) / HIZ_TILE_SIZE,
+                          (canvas->origin_y + y) / HIZ_TILE_SIZE);
+        if (tile->flags & CLEAR_COLOR) {
+            *px = tile->color;
+            return 0;
+        }
+    }
+    *px = canvas->data[y * canvas->stride + x];
     return 0;
 }
 
@@ -154,7 +817,8 @@ int canvas_set_px(canvas_t *const canvas, uint32_t x, uint32_t y,
         fprintf(stderr, "Got asked to set px out of range (%d, %d)\n", x, y);
         return -EDOM;
     }
-    canvas->data[y * canvas->width + x] = color;
+    canvas_resolve_rect(canvas, x, y, x, y, CLEAR_COLOR, false);
+    canvas->data[y * canvas->stride + x] = color;
     return 0;
 }
 
@@ -170,124 +834,821 @@ int canvas_blend_px(canvas_t *const canvas, uint32_t x, uint32_t y,
     return canvas_set_px(canvas, x, y, blend);
 }
 
-int canvas_fill(canvas_t *const canvas, struct rgba color) {
+/**
+ * Clips the span of len pixels starting at (x, y) to the canvas. Returns a
+ * pointer to its first pixel and stores the clipped length in len, or returns
+ * NULL if nothing is left.
+ */
+static struct rgba *canvas_clip_span(canvas_t *const canvas, int64_t x,
+                                     int64_t y, int64_t *len) {
+    if (y < 0 || y >= canvas->height)
+        return NULL;
+
+    int64_t end_x = MIN(x + *len, (int64_t)canvas->width);
+    x = MAX(x, 0);
+    if (end_x <= x)
+        return NULL;
+
+    *len = end_x - x;
+    canvas_resolve_rect(canvas, x, y, end_x - 1, y, CLEAR_COLOR, false);
+    return &canvas->data[y * canvas->stride + x];
+}
+
+/**
+ * Sets len pixels starting at (x, y) to color, clipped to the canvas.
+ */
+int canvas_set_span(canvas_t *const canvas, int64_t x, int64_t y, int64_t len,
+                    struct rgba color) {
     if (!canvas_valid(canvas))
         return -EINVAL;
 
-    int ret;
-    for (uint32_t x = 0; x < canvas->width; x++) {
-        for (uint32_t y = 0; y < canvas->height; y++) {
-            ret = canvas_set_px(canvas, x, y, color);
-            if (ret < 0)
-                return ret;
-        }
-    }
+    struct rgba *px = canvas_clip_span(canvas, x, y, &len);
+    if (px)
+        span_set(px, len, color);
     return 0;
 }
 
-int canvas_fill_rect(canvas_t *const canvas, uint32_t x, uint32_t y,
-                     uint32_t width, uint32_t height, struct rgba color) {
+/**
+ * Blends color over len pixels starting at (x, y), clipped to the canvas.
+ */
+int canvas_blend_span(canvas_t *const canvas, int64_t x, int64_t y,
+                      int64_t len, struct rgba color) {
     if (!canvas_valid(canvas))
         return -EINVAL;
 
-    int ret;
-    uint32_t clip_x = MIN(x + width, canvas->width);
-    uint32_t clip_y = MIN(y + height, canvas->height);
-
-    for (uint32_t iy = y; iy < clip_y; iy++) {
-        for (uint32_t ix = x; ix < clip_x; ix++) {
-            ret = canvas_blend_px(canvas, ix, iy, color);
-            if (ret < 0)
-                return ret;
-        }
-    }
+    struct rgba *px = canvas_clip_span(canvas, x, y, &len);
+    if (px)
+        span_blend(px, len, color);
     return 0;
 }
 
-int canvas_fill_circle(canvas_t *const canvas, int64_t center_x,
-                       int64_t center_y, uint32_t radius, struct rgba color) {
-    int ret;
-    uint32_t start_x = MAX(0, center_x - (int64_t)radius);
-    uint32_t start_y = MAX(0, center_y - (int64_t)radius);
-    uint32_t end_x =
-        MIN(canvas->width - 1, (uint32_t)(center_x + (int64_t)radius));
-    uint32_t end_y =
-        MIN(canvas->height - 1, (uint32_t)(center_y + (int64_t)radius));
+/**
+ * Blends the whole of layer over canvas with its top-left corner at (x, y),
+ * clipped to the canvas.
+ */
+int canvas_blend_canvas(canvas_t *const canvas, const canvas_t *const layer,
+                        int64_t x, int64_t y) {
+    if (!canvas_valid(canvas) || !canvas_valid(layer))
+        return -EINVAL;
 
-    for (uint32_t ix = start_x; ix <= end_x; ix++) {
-        for (uint32_t iy = start_y; iy <= end_y; iy++) {
-            int64_t offset_x = (int64_t)ix - center_x;
-            int64_t offset_y = (int64_t)iy - center_y;
-            if (offset_x * offset_x + offset_y * offset_y <= radius * radius) {
-                ret = canvas_blend_px(canvas, ix, iy, color);
-                if (ret < 0)
-                    return ret;
-            }
+    int64_t start_x = MAX(x, 0);
+    int64_t start_y = MAX(y, 0);
+    int64_t end_x = MIN(x + (int64_t)layer->width, (int64_t)canvas->width);
+    int64_t end_y = MIN(y + (int64_t)layer->height, (int64_t)canvas->height);
+    if (start_x >= end_x)
+        return 0;
+
+    canvas_resolve_rect(canvas, start_x, start_y, end_x - 1, end_y - 1,
+                        CLEAR_COLOR, false);
+    struct rgba buf[HIZ_TILE_SIZE];
+    for (int64_t iy = start_y; iy < end_y; iy++) {
+        struct rgba *dst = &canvas->data[iy * canvas->stride + start_x];
+        uint32_t n;
+        for (uint32_t lx = start_x - x; lx < end_x - x; lx += n, dst += n) {
+            const struct rgba *src =
+                canvas_shown_span(layer, lx, iy - y, end_x - x, buf, &n);
+            rgba_blend_span(dst, src, n);
         }
     }
-
     return 0;
 }
 
-typedef void (*barycentric_callback_t)(canvas_t *const canvas, int64_t x,
-                                       int64_t y, float u, float v, float w,
-                                       void *ctx);
+int canvas_fill(canvas_t *const canvas, struct rgba color) {
+    if (!canvas_valid(canvas))
+        return -EINVAL;
+    canvas_resolve_rect(canvas, 0, 0, (int64_t)canvas->width - 1,
+                        (int64_t)canvas->height - 1, CLEAR_COLOR, true);
 
-int calc_tri_barycentric(canvas_t *const canvas, point2_t v1, point2_t v2,
-                         point2_t v3, barycentric_callback_t callback,
-                         void *ctx) {
-    int64_t x0 = v1.x, y0 = v1.y;
-    int64_t x1 = v2.x, y1 = v2.y;
-    int64_t x2 = v3.x, y2 = v3.y;
-
-    // Bounding region
-    int64_t start_x = MIN(MIN(x0, x1), x2);
-    int64_t start_y = MIN(MIN(y0, y1), y2);
-    int64_t end_x = MAX(MAX(x0, x1), x2);
-    int64_t end_y = MAX(MAX(y0, y1), y2);
-    if (!(start_x >= 0 && start_y >= 0 && end_x < canvas->width &&
-          end_y < canvas->height)) {
-        return -EDOM;
+    // Without padding the rows are contiguous, so the whole canvas is one
+    // span. The padding of a canvas that owns its pixels is never shown, so
+    // it may be filled as well, but a view must keep to its rectangle.
+    if (canvas->stride == canvas->width || !canvas->parent) {
+        span_set(canvas->data, (size_t)canvas->stride * canvas->height, color);
+        return 0;
+    }
+    for (uint32_t y = 0; y < canvas->height; y++)
+        span_set(&canvas->data[(size_t)y * canvas->stride], canvas->width,
+                 color);
+    return 0;
+}
+
+/**
+ * Clears canvas to color, and its depth buffer if any to the far plane, by
+ * marking its tiles as cleared. Tiles of a view that it only partly covers
+ * are cleared right away.
+ */
+int canvas_clear(canvas_t *const canvas, struct rgba color) {
+    if (!canvas_valid(canvas))
+        return -EINVAL;
+
+    canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    size_t tile_count = (size_t)depth_tile_count(root->width) *
+                        depth_tile_count(root->height);
+    if (!root->clear_tiles) {
+        root->clear_tiles = mem_alloc(
+            root->alloc, tile_count * sizeof(struct clear_tile), CANVAS_ALIGN);
+        if (!root->clear_tiles) {
+            canvas_fill(canvas, color);
+            if (canvas->depth)
+                canvas_depth_reset(canvas);
+            return 0;
+        }
+        memset(root->clear_tiles, 0, tile_count * sizeof(struct clear_tile));
+    }
+
+    uint8_t flags = CLEAR_COLOR | (canvas->depth ? CLEAR_DEPTH : 0);
+    uint32_t x0 = canvas->origin_x, y0 = canvas->origin_y;
+    uint32_t x1 = x0 + canvas->width, y1 = y0 + canvas->height;
+    for (uint32_t ty = y0 / HIZ_TILE_SIZE; ty <= (y1 - 1) / HIZ_TILE_SIZE;
+         ty++) {
+        uint32_t tile_y0 = ty * HIZ_TILE_SIZE;
+        uint32_t tile_y1 = MIN(tile_y0 + HIZ_TILE_SIZE, root->height);
+        for (uint32_t tx = x0 / HIZ_TILE_SIZE; tx <= (x1 - 1) / HIZ_TILE_SIZE;
+             tx++) {
+            uint32_t tile_x0 = tx * HIZ_TILE_SIZE;
+            uint32_t tile_x1 = MIN(tile_x0 + HIZ_TILE_SIZE, root->width);
+            struct clear_tile *tile = clear_tile_at(root, tx, ty);
+            if (tile_x0 >= x0 && tile_x1 <= x1 && tile_y0 >= y0 &&
+                tile_y1 <= y1) {
+                if (!(tile->flags & CLEAR_CLEAN) ||
+                    !rgba_eql(tile->color, color)) {
+                    tile->color = color;
+                    tile->flags = (tile->flags & ~CLEAR_CLEAN) | CLEAR_COLOR;
+                    if (root->dirty_tiles)
+                        dirty_tile_mark(root, tx, ty);
+                }
+                tile->flags |= flags & CLEAR_DEPTH;
+                continue;
+            }
+
+            clear_tile_touch(root, tx, ty, flags);
+            if (root->dirty_tiles)
+                dirty_tile_mark(root, tx, ty);
+            uint32_t cx0 = MAX(tile_x0, x0), cx1 = MIN(tile_x1, x1);
+            uint32_t cy0 = MAX(tile_y0, y0), cy1 = MIN(tile_y1, y1);
+            for (uint32_t y = cy0; y < cy1; y++)
+                span_set(&root->data[(size_t)y * root->stride + cx0],
+                         cx1 - cx0, color);
+            if (canvas->depth)
+                depth_rect_reset(root, cx0, cy0, cx1, cy1);
+        }
+    }
+
+    if (canvas->depth) {
+        depth_tiles_reset(root, x0, y0, x1, y1);
+        canvas->depth_stats = (struct depth_stats){0};
+        canvas->cull_stats = (struct cull_stats){0};
+    }
+    return 0;
+}
+
+/**
+ * Writes out the clear color of every tile of canvas still pending, as
+ * presenting or exporting it needs. Resolving writes only what the canvas
+ * already shows.
+ */
+void canvas_resolve(canvas_t *const canvas) {
+    canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    if (!root->clear_tiles || canvas->width == 0 || canvas->height == 0)
+        return;
+
+    uint32_t x0 = canvas->origin_x, y0 = canvas->origin_y;
+    uint32_t x1 = x0 + canvas->width - 1, y1 = y0 + canvas->height - 1;
+    for (uint32_t ty = y0 / HIZ_TILE_SIZE; ty <= y1 / HIZ_TILE_SIZE; ty++) {
+        for (uint32_t tx = x0 / HIZ_TILE_SIZE; tx <= x1 / HIZ_TILE_SIZE;
+             tx++) {
+            struct clear_tile *tile = clear_tile_at(root, tx, ty);
+            if (!(tile->flags & CLEAR_COLOR))
+                continue;
+            clear_tile_write(root, tx, ty, CLEAR_COLOR);
+            tile->flags |= CLEAR_CLEAN;
+        }
+    }
+}
+
+/**
+ * Dirty tracking. canvas_track_dirty gives the root canvas a byte for each
+ * HIZ_TILE_SIZE tile, set by everything that writes pixels of the tile, so a
+ * presenter can upload or export only the tiles drawn into since the last
+ * canvas_dirty_reset. Writers mark the tiles as they resolve them, and
+ * triangles mark the tiles of their bounding box the coarse depth test keeps.
+ * canvas_clear marks only the tiles it changes: a clean tile cleared to the
+ * color it holds stays untouched. Tiles are bytes rather than bits so that
+ * threads drawing neighbouring tiles of a binner never share a word, and a
+ * binner lines its tiles up with these even on a view off the grid, so that
+ * no two of its threads mark the same one.
+ */
+
+/**
+ * Starts tracking which tiles of canvas, or of the canvas it is a view of,
+ * get drawn into. Every tile starts out dirty, as nothing has been presented
+ * yet.
+ */
+int canvas_track_dirty(canvas_t *const canvas) {
+    if (!canvas_valid(canvas))
+        return -EINVAL;
+
+    canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    size_t tile_count = (size_t)depth_tile_count(root->width) *
+                        depth_tile_count(root->height);
+    if (!root->dirty_tiles) {
+        root->dirty_tiles = mem_alloc(root->alloc, tile_count, CANVAS_ALIGN);
+        if (!root->dirty_tiles)
+            return -ENOMEM;
+    }
+    memset(root->dirty_tiles, 1, tile_count);
+    return 0;
+}
+
+/**
+ * Marks every tile overlapping canvas clean, typically once a frame has been
+ * presented. Tiles whose fast clear is still pending stay dirty, as resolving
+ * them will write their color.
+ */
+void canvas_dirty_reset(canvas_t *const canvas) {
+    canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    if (!root->dirty_tiles || canvas->width == 0 || canvas->height == 0)
+        return;
+
+    uint32_t tiles_x = depth_tile_count(root->width);
+    uint32_t x0 = canvas->origin_x, y0 = canvas->origin_y;
+    uint32_t x1 = x0 + canvas->width - 1, y1 = y0 + canvas->height - 1;
+    for (uint32_t ty = y0 / HIZ_TILE_SIZE; ty <= y1 / HIZ_TILE_SIZE; ty++) {
+        for (uint32_t tx = x0 / HIZ_TILE_SIZE; tx <= x1 / HIZ_TILE_SIZE;
+             tx++) {
+            root->dirty_tiles[(size_t)ty * tiles_x + tx] =
+                root->clear_tiles &&
+                (clear_tile_at(root, tx, ty)->flags & CLEAR_COLOR);
+        }
+    }
+}
+
+/**
+ * Returns whether tile (tx, ty), the HIZ_TILE_SIZE square at
+ * (tx * HIZ_TILE_SIZE, ty * HIZ_TILE_SIZE) of the root canvas, was drawn into
+ * since the last canvas_dirty_reset. Untracked canvases are dirty everywhere.
+ */
+bool canvas_tile_dirty(const canvas_t *const canvas, uint32_t tx,
+                       uint32_t ty) {
+    const canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    uint32_t tiles_x = depth_tile_count(root->width);
+    if (!root->dirty_tiles || tx >= tiles_x ||
+        ty >= depth_tile_count(root->height))
+        return true;
+    return root->dirty_tiles[(size_t)ty * tiles_x + tx];
+}
+
+/**
+ * Stores the dirty tiles of canvas in rects (struct dirty_rect) as few
+ * disjoint rectangles, in the canvas's own coordinates and clipped to it.
+ * Runs of dirty tiles along a row make a rectangle, which grows downwards
+ * while the rows below have a run over the same columns. rects must have been
+ * made with ARRAY_MAKE. Returns the number of rectangles, or -ENOMEM if rects
+ * could not grow to hold them all.
+ */
+int canvas_dirty_rects(const canvas_t *const canvas, arraylist_t *const rects) {
+    const canvas_t *root = canvas->parent ? canvas->parent : canvas;
+    rects->count = 0;
+    if (canvas->width == 0 || canvas->height == 0)
+        return 0;
+    if (!root->dirty_tiles) {
+        struct dirty_rect all = {0, 0, canvas->width, canvas->height};
+        int ret = array_push(rects, &all, sizeof(all));
+        return ret < 0 ? ret : (int)rects->count;
+    }
+
+    uint32_t tiles_x = depth_tile_count(root->width);
+    uint32_t ox = canvas->origin_x, oy = canvas->origin_y;
+    uint32_t end_x = ox + canvas->width, end_y = oy + canvas->height;
+    uint32_t tx0 = ox / HIZ_TILE_SIZE, tx1 = (end_x - 1) / HIZ_TILE_SIZE;
+
+    // Rectangles from open on reach the row above and may grow into this one.
+    // Those that do move to the end of that range, just before the ones this
+    // row starts, so the rectangles reaching this row follow each other.
+    size_t open = 0;
+    for (uint32_t ty = oy / HIZ_TILE_SIZE; ty <= (end_y - 1) / HIZ_TILE_SIZE;
+         ty++) {
+        const uint8_t *row = &root->dirty_tiles[(size_t)ty * tiles_x];
+        uint32_t y0 = MAX(ty * HIZ_TILE_SIZE, oy) - oy;
+        uint32_t y1 = MIN((ty + 1) * HIZ_TILE_SIZE, end_y) - oy;
+        size_t grown = rects->count;
+
+        for (uint32_t tx = tx0; tx <= tx1; tx++) {
+            if (!row[tx])
+                continue;
+            uint32_t run_end = tx;
+            while (run_end < tx1 && row[run_end + 1])
+                run_end++;
+
+            uint32_t x0 = MAX(tx * HIZ_TILE_SIZE, ox) - ox;
+            uint32_t x1 = MIN((run_end + 1) * HIZ_TILE_SIZE, end_x) - ox;
+            struct dirty_rect *r = rects->data;
+            size_t i = open;
+            while (i < grown && !(r[i].x == x0 && r[i].width == x1 - x0 &&
+                                  r[i].y + r[i].height == y0))
+                i++;
+            if (i < grown) {
+                struct dirty_rect rect = r[i];
+                rect.height += y1 - y0;
+                r[i] = r[--grown];
+                r[grown] = rect;
+            } else {
+                struct dirty_rect rect = {x0, y0, x1 - x0, y1 - y0};
+                int ret = array_push(rects, &rect, sizeof(rect));
+                if (ret < 0)
+                    return ret;
+            }
+            tx = run_end;
+        }
+        open = grown;
+    }
+    return (int)rects->count;
+}
+
+/**
+ * An inclusive rectangle of pixels that a draw is clipped to. Drawing a shape
+ * tile by tile, each clipped to its tile, writes exactly the pixels drawing
+ * it clipped to the canvas would.
+ */
+struct clip_rect {
+    int64_t x0, y0, x1, y1;
+};
+
+static inline struct clip_rect canvas_clip_rect(const canvas_t *const canvas) {
+    return (struct clip_rect){0, 0, (int64_t)canvas->width - 1,
+                              (int64_t)canvas->height - 1};
+}
+
+/**
+ * Blends color over the pixels [x0, x1] x [y0, y1] within clip.
+ */
+static void rect_blend(canvas_t *const canvas, int64_t x0, int64_t y0,
+                       int64_t x1, int64_t y1, struct rgba color,
+                       struct clip_rect clip) {
+    x0 = MAX(x0, clip.x0);
+    y0 = MAX(y0, clip.y0);
+    x1 = MIN(x1, clip.x1);
+    y1 = MIN(y1, clip.y1);
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    canvas_resolve_rect(canvas, x0, y0, x1, y1, CLEAR_COLOR, false);
+    for (int64_t iy = y0; iy <= y1; iy++)
+        span_blend(&canvas->data[iy * canvas->stride + x0], x1 - x0 + 1,
+                   color);
+}
+
+/**
+ * The pixels canvas_fill_rect covers, as an inclusive rectangle that may be
+ * empty.
+ */
+static struct clip_rect fill_rect_bounds(const canvas_t *const canvas,
+                                         uint32_t x, uint32_t y,
+                                         uint32_t width, uint32_t height) {
+    uint32_t clip_x = MIN(x + width, canvas->width);
+    uint32_t clip_y = MIN(y + height, canvas->height);
+    return (struct clip_rect){x, y, (int64_t)clip_x - 1, (int64_t)clip_y - 1};
+}
+
+int canvas_fill_rect(canvas_t *const canvas, uint32_t x, uint32_t y,
+                     uint32_t width, uint32_t height, struct rgba color) {
+    if (!canvas_valid(canvas))
+        return -EINVAL;
+
+    struct clip_rect r = fill_rect_bounds(canvas, x, y, width, height);
+    rect_blend(canvas, r.x0, r.y0, r.x1, r.y1, color,
+               canvas_clip_rect(canvas));
+    return 0;
+}
+
+/**
+ * Largest dx >= 0 with dx * dx + dy2 <= limit, stepping down from the previous
+ * row's value. Walking rows away from the center only ever shrinks it, so a
+ * whole circle costs O(radius) steps.
+ */
+static inline int64_t circle_half_width(int64_t hw, int64_t dy2,
+                                        int64_t limit) {
+    while (hw >= 0 && hw * hw + dy2 > limit)
+        hw--;
+    return hw;
+}
+
+/**
+ * Blends the pixels [x0, x1] of row y, clipped to clip.
+ */
+static inline void canvas_blend_row(canvas_t *const canvas, int64_t x0,
+                                    int64_t x1, int64_t y, struct rgba color,
+                                    struct clip_rect clip) {
+    if (y < clip.y0 || y > clip.y1)
+        return;
+    x0 = MAX(x0, clip.x0);
+    x1 = MIN(x1, clip.x1);
+    if (x0 > x1)
+        return;
+    canvas_resolve_rect(canvas, x0, y, x1, y, CLEAR_COLOR, false);
+    span_blend(&canvas->data[y * canvas->stride + x0], x1 - x0 + 1, color);
+}
+
+static void circle_fill(canvas_t *const canvas, int64_t center_x,
+                        int64_t center_y, uint32_t radius, struct rgba color,
+                        struct clip_rect clip) {
+    int64_t r = radius;
+    int64_t hw = r;
+    for (int64_t dy = 0; dy <= r; dy++) {
+        hw = circle_half_width(hw, dy * dy, r * r);
+        canvas_blend_row(canvas, center_x - hw, center_x + hw, center_y + dy,
+                         color, clip);
+        if (dy > 0)
+            canvas_blend_row(canvas, center_x - hw, center_x + hw,
+                             center_y - dy, color, clip);
+    }
+}
+
+/**
+ * Fills every pixel whose center lies within radius of the center, as one
+ * span per row.
+ */
+int canvas_fill_circle(canvas_t *const canvas, int64_t center_x,
+                       int64_t center_y, uint32_t radius, struct rgba color) {
+    if (!canvas_valid(canvas))
+        return -EINVAL;
+
+    circle_fill(canvas, center_x, center_y, radius, color,
+                canvas_clip_rect(canvas));
+    return 0;
+}
+
+static inline void canvas_blend_coverage(canvas_t *const canvas, int64_t x,
+                                         int64_t y, struct rgba color,
+                                         float coverage,
+                                         struct clip_rect clip) {
+    if (x < clip.x0 || x > clip.x1 || y < clip.y0 || y > clip.y1)
+        return;
+    color.a = (uint8_t)(color.a * coverage + 0.5f);
+    canvas_resolve_rect(canvas, x, y, x, y, CLEAR_COLOR, false);
+    struct rgba *px = &canvas->data[y * canvas->stride + x];
+    *px = rgba_alpha_blend(color, *px);
+}
+
+static void circle_fill_aa(canvas_t *const canvas, int64_t center_x,
+                           int64_t center_y, uint32_t radius,
+                           struct rgba color, struct clip_rect clip) {
+    // With integer offsets, d^2 <= (r - 0.5)^2 <=> d^2 <= r^2 - r, and
+    // d^2 < (r + 0.5)^2 <=> d^2 <= r^2 + r.
+    int64_t r = radius;
+    int64_t inner = r * r - r;
+    int64_t outer = r * r + r;
+    int64_t hw_in = r - 1;
+    int64_t hw_out = r;
+
+    for (int64_t dy = 0; dy <= r; dy++) {
+        int64_t dy2 = dy * dy;
+        hw_in = circle_half_width(hw_in, dy2, inner);
+        hw_out = circle_half_width(hw_out, dy2, outer);
+
+        for (int side = 0; side < (dy > 0 ? 2 : 1); side++) {
+            int64_t y = side ? center_y - dy : center_y + dy;
+            if (y < clip.y0 || y > clip.y1)
+                continue;
+
+            canvas_blend_row(canvas, center_x - hw_in, center_x + hw_in, y,
+                             color, clip);
+            for (int64_t dx = MAX(hw_in + 1, 0); dx <= hw_out; dx++) {
+                float coverage =
+                    (float)r + 0.5f - sqrtf((float)(dx * dx + dy2));
+                coverage = MIN(MAX(coverage, 0.0f), 1.0f);
+                canvas_blend_coverage(canvas, center_x + dx, y, color,
+                                      coverage, clip);
+                if (dx > 0)
+                    canvas_blend_coverage(canvas, center_x - dx, y, color,
+                                          coverage, clip);
+            }
+        }
     }
+}
+
+/**
+ * Antialiased canvas_fill_circle. A pixel is covered by how far its center
+ * lies inside the edge, clamp(radius + 0.5 - distance, 0, 1). Pixels within
+ * radius - 0.5 are filled as spans, and only the boundary pixels between that
+ * and radius + 0.5 compute a distance.
+ */
+int canvas_fill_circle_aa(canvas_t *const canvas, int64_t center_x,
+                          int64_t center_y, uint32_t radius,
+                          struct rgba color) {
+    if (!canvas_valid(canvas))
+        return -EINVAL;
+
+    circle_fill_aa(canvas, center_x, center_y, radius, color,
+                   canvas_clip_rect(canvas));
+    return 0;
+}
+
+typedef void (*barycentric_callback_t)(canvas_t *const canvas, int64_t x,
+                                       int64_t y, float u, float v, float w,
+                                       void *ctx);
+
+/**
+ * Edge function of edge (a, b), set up for incremental stepping. Its value at
+ * the fixed point position (X, Y) is `(X - a.x) * x + (Y - a.y) * y`, so
+ * moving one pixel right adds step_x and moving one row down adds step_y.
+ */
+struct tri_edge {
+    int32_t x, y;
+    int32_t step_x;
+    int32_t step_y;
+    int32_t bias; // 0 for top-left edges, -1 otherwise
+};
+
+static struct tri_edge tri_edge_setup(struct vec2fx a, struct vec2fx b,
+                                      int32_t sign) {
+    struct tri_edge edge = {
+        .x = (a.y - b.y) * sign,
+        .y = (b.x - a.x) * sign,
+    };
+    edge.step_x = edge.x * SUBPIXEL_ONE;
+    edge.step_y = edge.y * SUBPIXEL_ONE;
+
+    // Top-left fill rule: pixels lying exactly on an edge are only covered if
+    // it is a left edge (interior to its right) or a horizontal top edge
+    // (interior below it). Triangles sharing an edge never both draw it.
+    bool top_left = edge.x > 0 || (edge.x == 0 && edge.y > 0);
+    edge.bias = top_left ? 0 : -1;
+    return edge;
+}
+
+static inline int32_t tri_edge_eval(struct tri_edge edge, struct vec2fx a,
+                                    int64_t x, int64_t y) {
+    int32_t dx = (int32_t)(x * SUBPIXEL_ONE - a.x);
+    int32_t dy = (int32_t)(y * SUBPIXEL_ONE - a.y);
+    return dx * edge.x + dy * edge.y;
+}
+
+/**
+ * Triangles at most RASTER_FIXED_MAX_DIM pixels on each side are set up and
+ * stepped in 32 bits. Their edge coefficients are then at most
+ * D = RASTER_FIXED_MAX_DIM * SUBPIXEL_ONE, and pixels up to
+ * RASTER_FIXED_MARGIN past their bounding box, which covers SIMD blocks
+ * overhanging its end and the corners of Hi-Z tiles, are at most
+ * D + RASTER_FIXED_MARGIN * SUBPIXEL_ONE from any vertex along each axis:
+ * |edge| <= 2 * 32000 * 32256 < 2^31. Larger triangles fall back to 64 bits.
+ */
+#define RASTER_FIXED_MAX_DIM 2000
+#define RASTER_FIXED_MARGIN 16
 
-    int64_t dy01 = y0 - y1;
-    int64_t dy12 = y1 - y2;
-    int64_t dy20 = y2 - y0;
-    int64_t area = x0 * dy12 + x1 * dy20 + x2 * dy01;
+_Static_assert(2LL * RASTER_FIXED_MAX_DIM * SUBPIXEL_ONE *
+                       (RASTER_FIXED_MAX_DIM + RASTER_FIXED_MARGIN) *
+                       SUBPIXEL_ONE <=
+                   INT32_MAX,
+               "edge functions must fit 32 bits");
+_Static_assert(SIMD_LANES < RASTER_FIXED_MARGIN &&
+                   HIZ_TILE_SIZE <= RASTER_FIXED_MARGIN,
+               "blocks and tiles may not reach past the margin");
+
+/**
+ * Per-triangle raster state: the bounding box clipped to the clip rectangle,
+ * the three edges and their values at (start_x, start_y).
+ */
+struct tri_setup {
+    int64_t start_x, start_y;
+    int64_t end_x, end_y;
+    struct tri_edge e[3];
+    int32_t row[3];
+    float inv_area;
+};
+
+/**
+ * Sets up t for the part of (v1, v2, v3) inside the clip rectangle. Returns
+ * -EDOM for degenerate triangles and -ERANGE for triangles too large for
+ * 32-bit edge functions.
+ */
+static int tri_setup_init(struct tri_setup *const t, struct vec2fx v1,
+                          struct vec2fx v2, struct vec2fx v3, int64_t clip_x0,
+                          int64_t clip_y0, int64_t clip_x1, int64_t clip_y1) {
+    int32_t min_x = MIN(MIN(v1.x, v2.x), v3.x);
+    int32_t min_y = MIN(MIN(v1.y, v2.y), v3.y);
+    int32_t max_x = MAX(MAX(v1.x, v2.x), v3.x);
+    int32_t max_y = MAX(MAX(v1.y, v2.y), v3.y);
+    if ((int64_t)max_x - min_x > RASTER_FIXED_MAX_DIM * SUBPIXEL_ONE ||
+        (int64_t)max_y - min_y > RASTER_FIXED_MAX_DIM * SUBPIXEL_ONE)
+        return -ERANGE;
+
+    int32_t area =
+        (v2.x - v1.x) * (v3.y - v1.y) - (v2.y - v1.y) * (v3.x - v1.x);
     if (area == 0)
         return -EDOM; // no degenerate triangles
 
-    for (int64_t ix = start_x; ix <= end_x; ix++) {
-        for (int64_t iy = start_y; iy <= end_y; iy++) {
-            int64_t area_p12 = ix * dy12 + x1 * (y2 - iy) + x2 * (iy - y1);
-            int64_t area_p02 = ix * dy20 + x2 * (y0 - iy) + x0 * (iy - y2);
-            int64_t area_p01 = ix * dy01 + x0 * (y1 - iy) + x1 * (iy - y0);
-            float u = (float)area_p12 / area;
-            float v = (float)area_p02 / area;
-            float w = (float)area_p01 / area;
-
-            if (IN_IRANGEF(u, 0, 1, 1e-3) && IN_IRANGEF(v, 0, 1, 1e-3) &&
-                IN_IRANGEF(w, 0, 1, 1e-3)) {
-                callback(canvas, ix, iy, u, v, w, ctx);
+    t->start_x = MAX(fx_ceil_px(min_x), clip_x0);
+    t->start_y = MAX(fx_ceil_px(min_y), clip_y0);
+    t->end_x = MIN(fx_floor_px(max_x), clip_x1);
+    t->end_y = MIN(fx_floor_px(max_y), clip_y1);
+
+    // Flip the edge functions of clockwise triangles so that the interior is
+    // always positive.
+    int32_t sign = area > 0 ? 1 : -1;
+    t->inv_area = 1.0f / (float)(area * sign);
+
+    // Edge i is opposite vertex i, so its value is that vertex' weight.
+    t->e[0] = tri_edge_setup(v2, v3, sign);
+    t->e[1] = tri_edge_setup(v3, v1, sign);
+    t->e[2] = tri_edge_setup(v1, v2, sign);
+
+    t->row[0] = tri_edge_eval(t->e[0], v2, t->start_x, t->start_y);
+    t->row[1] = tri_edge_eval(t->e[1], v3, t->start_x, t->start_y);
+    t->row[2] = tri_edge_eval(t->e[2], v1, t->start_x, t->start_y);
+    return 0;
+}
+
+/**
+ * Walks the bounding box of t row by row, stepping the three edge functions
+ * with adds, and invokes callback with the barycentric weights (u, v, w) of
+ * v1, v2 and v3 for every covered pixel.
+ */
+static void tri_raster_rows(canvas_t *const canvas,
+                            const struct tri_setup *const t,
+                            barycentric_callback_t callback, void *ctx) {
+    const struct tri_edge *e = t->e;
+    int32_t row0 = t->row[0], row1 = t->row[1], row2 = t->row[2];
+    for (int64_t iy = t->start_y; iy <= t->end_y; iy++) {
+        int32_t w0 = row0, w1 = row1, w2 = row2;
+        for (int64_t ix = t->start_x; ix <= t->end_x; ix++) {
+            if ((w0 + e[0].bias) >= 0 && (w1 + e[1].bias) >= 0 &&
+                (w2 + e[2].bias) >= 0) {
+                callback(canvas, ix, iy, (float)w0 * t->inv_area,
+                         (float)w1 * t->inv_area, (float)w2 * t->inv_area,
+                         ctx);
             }
+            w0 += e[0].step_x;
+            w1 += e[1].step_x;
+            w2 += e[2].step_x;
         }
+        row0 += e[0].step_y;
+        row1 += e[1].step_y;
+        row2 += e[2].step_y;
+    }
+}
+
+/**
+ * tri_raster for triangles past RASTER_FIXED_MAX_DIM, with the same edge
+ * functions evaluated in 64 bits.
+ */
+static int tri_raster_wide(canvas_t *const canvas, struct vec2fx v1,
+                           struct vec2fx v2, struct vec2fx v3, int64_t clip_x0,
+                           int64_t clip_y0, int64_t clip_x1, int64_t clip_y1,
+                           barycentric_callback_t callback, void *ctx) {
+    const struct vec2fx v[3] = {v1, v2, v3};
+    int64_t area = (int64_t)(v2.x - v1.x) * (v3.y - v1.y) -
+                   (int64_t)(v2.y - v1.y) * (v3.x - v1.x);
+    if (area == 0)
+        return -EDOM;
+
+    int64_t start_x = MAX(fx_ceil_px(MIN(MIN(v1.x, v2.x), v3.x)), clip_x0);
+    int64_t start_y = MAX(fx_ceil_px(MIN(MIN(v1.y, v2.y), v3.y)), clip_y0);
+    int64_t end_x = MIN(fx_floor_px(MAX(MAX(v1.x, v2.x), v3.x)), clip_x1);
+    int64_t end_y = MIN(fx_floor_px(MAX(MAX(v1.y, v2.y), v3.y)), clip_y1);
+    int64_t sign = area > 0 ? 1 : -1;
+    float inv_area = 1.0f / (float)(area * sign);
+
+    int64_t step_x[3], step_y[3], bias[3], row[3];
+    for (int i = 0; i < 3; i++) {
+        struct vec2fx a = v[(i + 1) % 3];
+        struct vec2fx b = v[(i + 2) % 3];
+        int64_t ex = (int64_t)(a.y - b.y) * sign;
+        int64_t ey = (int64_t)(b.x - a.x) * sign;
+        step_x[i] = ex * SUBPIXEL_ONE;
+        step_y[i] = ey * SUBPIXEL_ONE;
+        bias[i] = ex > 0 || (ex == 0 && ey > 0) ? 0 : -1;
+        row[i] = (start_x * SUBPIXEL_ONE - a.x) * ex +
+                 (start_y * SUBPIXEL_ONE - a.y) * ey;
     }
 
+    for (int64_t iy = start_y; iy <= end_y; iy++) {
+        int64_t w0 = row[0], w1 = row[1], w2 = row[2];
+        for (int64_t ix = start_x; ix <= end_x; ix++) {
+            if (w0 + bias[0] >= 0 && w1 + bias[1] >= 0 && w2 + bias[2] >= 0) {
+                callback(canvas, ix, iy, (float)w0 * inv_area,
+                         (float)w1 * inv_area, (float)w2 * inv_area, ctx);
+            }
+            w0 += step_x[0];
+            w1 += step_x[1];
+            w2 += step_x[2];
+        }
+        for (int i = 0; i < 3; i++)
+            row[i] += step_y[i];
+    }
     return 0;
 }
 
-static void tri_fill_at_point(canvas_t *const canvas, int64_t x, int64_t y,
-                                float u, float v, float w, void *ctx) {
-    canvas_blend_px(canvas, x, y, *(struct rgba *)ctx);
+/**
+ * Rasterizes the part of triangle (v1, v2, v3) inside the inclusive clip
+ * rectangle (clip_x0, clip_y0)-(clip_x1, clip_y1), invoking callback with the
+ * barycentric weights (u, v, w) of v1, v2 and v3 for every covered pixel.
+ *
+ * Coverage follows the top-left fill rule, and both windings are accepted.
+ * Edge values are exact, so splitting a triangle across several clip
+ * rectangles covers the same pixels with the same weights.
+ */
+static int tri_raster(canvas_t *const canvas, struct vec2fx v1,
+                      struct vec2fx v2, struct vec2fx v3, int64_t clip_x0,
+                      int64_t clip_y0, int64_t clip_x1, int64_t clip_y1,
+                      barycentric_callback_t callback, void *ctx) {
+    struct tri_setup t;
+    int ret = tri_setup_init(&t, v1, v2, v3, clip_x0, clip_y0, clip_x1,
+                             clip_y1);
+    if (ret == -ERANGE)
+        return tri_raster_wide(canvas, v1, v2, v3, clip_x0, clip_y0, clip_x1,
+                               clip_y1, callback, ctx);
+    if (ret < 0)
+        return ret;
+
+    tri_raster_rows(canvas, &t, callback, ctx);
+    return 0;
 }
 
-int canvas_fill_tri(canvas_t *const canvas, int64_t x0, int64_t y0, int64_t x1,
-                    int64_t y1, int64_t x2, int64_t y2, struct rgba color) {
-    point2_t v1 = {x0, y0};
-    point2_t v2 = {x1, y1};
-    point2_t v3 = {x2, y2};
-    return calc_tri_barycentric(canvas, v1, v2, v3, &tri_fill_at_point,
-                                &color);
+/**
+ * Triangles are not clipped against the canvas edges as polygons. Instead the
+ * raster loops scissor their bounding box to the canvas, which works for any
+ * vertex within GUARD_BAND pixels of the canvas. Only 3D triangles reaching
+ * past the guard band (or through the near plane) are clipped geometrically.
+ */
+#define GUARD_BAND 4096
+
+_Static_assert((int64_t)(CANVAS_MAX_DIM + GUARD_BAND) * SUBPIXEL_ONE <
+                   INT32_MAX,
+               "guard band coordinates must fit 28.4 fixed point");
+
+static bool tri_in_guard_band(const canvas_t *const canvas, point2_t v1,
+                              point2_t v2, point2_t v3) {
+    int64_t start_x = MIN(MIN(v1.x, v2.x), v3.x);
+    int64_t start_y = MIN(MIN(v1.y, v2.y), v3.y);
+    int64_t end_x = MAX(MAX(v1.x, v2.x), v3.x);
+    int64_t end_y = MAX(MAX(v1.y, v2.y), v3.y);
+    return start_x >= -GUARD_BAND && start_y >= -GUARD_BAND &&
+           end_x < (int64_t)canvas->width + GUARD_BAND &&
+           end_y < (int64_t)canvas->height + GUARD_BAND;
+}
+
+/**
+ * canvas_resolve_rect for the bounding box of triangle (v1, v2, v3) within
+ * the clip rectangle.
+ */
+static void tri_resolve_box(canvas_t *const canvas, struct vec2fx v1,
+                            struct vec2fx v2, struct vec2fx v3, int64_t clip_x0,
+                            int64_t clip_y0, int64_t clip_x1, int64_t clip_y1,
+                            uint8_t flags) {
+    int64_t x0 = fx_floor_px(MIN(MIN(v1.x, v2.x), v3.x));
+    int64_t y0 = fx_floor_px(MIN(MIN(v1.y, v2.y), v3.y));
+    int64_t x1 = fx_floor_px(MAX(MAX(v1.x, v2.x), v3.x));
+    int64_t y1 = fx_floor_px(MAX(MAX(v1.y, v2.y), v3.y));
+    canvas_resolve_rect(canvas, MAX(x0, clip_x0), MAX(y0, clip_y0),
+                        MIN(x1, clip_x1), MIN(y1, clip_y1), flags, false);
+}
+
+/**
+ * Rasterizes the triangle (v1, v2, v3), clipped to the canvas. Vertices may
+ * lie up to GUARD_BAND pixels off the canvas.
+ */
+int calc_tri_barycentric(canvas_t *const canvas, point2_t v1, point2_t v2,
+                         point2_t v3, barycentric_callback_t callback,
+                         void *ctx) {
+    if (!tri_in_guard_band(canvas, v1, v2, v3))
+        return -EDOM;
+
+    struct vec2fx p1 = vec2fx_from_px(v1);
+    struct vec2fx p2 = vec2fx_from_px(v2);
+    struct vec2fx p3 = vec2fx_from_px(v3);
+    tri_resolve_box(canvas, p1, p2, p3, 0, 0, canvas->width - 1,
+                    canvas->height - 1, CLEAR_COLOR | CLEAR_DEPTH);
+    return tri_raster(canvas, p1, p2, p3, 0, 0, canvas->width - 1,
+                      canvas->height - 1, callback, ctx);
+}
+
+/**
+ * The built-in ways of shading a triangle. These match tri_fill_at_point,
+ * tri_interp_rgb and tri_interp_rgb_depth, but are known to the rasterizer so
+ * it can evaluate them SIMD_LANES pixels at a time instead of calling back
+ * for every pixel.
+ */
+enum tri_shade_mode {
+    TRI_SHADE_FLAT,      // Blend a single color
+    TRI_SHADE_RGB,       // Interpolate red, green and blue from the weights
+    TRI_SHADE_RGB_DEPTH, // TRI_SHADE_RGB with a depth test, see depth_key
+};
+
+struct tri_shader {
+    enum tri_shade_mode mode;
+    struct rgba color;  // TRI_SHADE_FLAT
+    const float *depth; // TRI_SHADE_RGB_DEPTH: The depth_key of each vertex
+
+    // TRI_SHADE_RGB_DEPTH: The color weights of each vertex, for triangles cut
+    // out of a larger one by clipping. NULL means (1,0,0), (0,1,0), (0,0,1).
+    const struct vec3f *weights;
+};
+
+static void tri_fill_at_point(canvas_t *const canvas, int64_t x, int64_t y,
+                              float u, float v, float w, void *ctx) {
+    (void)u, (void)v, (void)w;
+    canvas_blend_px(canvas, x, y, *(struct rgba *)ctx);
 }
 
 static struct rgba color_lerp_rgb(float u, float v, float w) {
@@ -302,38 +1663,545 @@ static struct rgba color_lerp_rgb(float u, float v, float w) {
 
 static void tri_interp_rgb(canvas_t *const canvas, int64_t x, int64_t y,
                            float u, float v, float w, void *ctx) {
+    (void)ctx;
     canvas_blend_px(canvas, x, y, color_lerp_rgb(u, v, w));
 }
 
-void canvas_fill_triInterpolated(canvas_t *const canvas, point2_t v1,
-                                 point2_t v2, point2_t v3) {
-    calc_tri_barycentric(canvas, v1, v2, v3, &tri_interp_rgb, NULL);
+#define DEPTH_UNORM16_MAX 0xFFFFu
+#define DEPTH_UNORM24_MAX 0xFFFFFFu
+
+/**
+ * The value the rasterizer interpolates across a triangle for the depth of a
+ * camera space vertex, smaller being nearer in every format: z itself for
+ * DEPTH_F32, and -near / (z + dist) for the others, which store its negation.
+ * 1 / d is linear in screen space where d is not, so reversed depths
+ * interpolate exactly and keep their precision near the camera.
+ */
+static inline float depth_key(const canvas_t *const canvas, point3_t p,
+                              float dist) {
+    if (canvas->depth_format == DEPTH_F32)
+        return p.z;
+    return -canvas->depth_near / (p.z + dist);
 }
 
-int canvas_fill_quad(canvas_t *const canvas, point2_t p1, point2_t p2,
-                     point2_t p3, point2_t p4, struct rgba color) {
-    // We require the quad to be sorted for now.
-    assert(p1.x < p2.x && p1.x < p3.x && p1.x < p4.x);
-    assert(p4.x > p3.x && p4.x > p2.x && p4.x > p1.x);
+/**
+ * Quantizes a reversed depth to a unorm of max steps, rounding to nearest.
+ * Near 1, r * max + 0.5 can round up past a 24-bit max in float, which would
+ * wrap to the far plane when stored, so the result is clamped to max.
+ */
+static inline uint32_t depth_unorm(float r, uint32_t max) {
+    uint32_t q = (uint32_t)(MIN(MAX(r, 0.f), 1.f) * (float)max + 0.5f);
+    return MIN(q, max);
+}
 
-    int ret;
-    ret = canvas_fill_tri(canvas, p1.x, p1.y, p2.x, p2.y, p3.x, p3.y, color);
-    if (ret < 0)
-        return ret;
-    ret = canvas_fill_tri(canvas, p4.x, p4.y, p2.x, p2.y, p3.x, p3.y, color);
-    if (ret < 0)
-        return ret;
-    return 0;
+/**
+ * The largest error depth_unorm can make in a depth key, which a coarse depth
+ * bound has to allow for.
+ */
+static inline float depth_quantum(enum depth_format format) {
+    switch (format) {
+    case DEPTH_UNORM24:
+        return 1.f / DEPTH_UNORM24_MAX;
+    case DEPTH_UNORM16:
+        return 1.f / DEPTH_UNORM16_MAX;
+    default:
+        return 0;
+    }
 }
 
 /**
- * Draws a line from point (x0, y0) to (x1, y1) of width 1.
- *
- * @todo Antialiasing
+ * Tests key against the depth stored at (x, y) and stores it if it is nearer.
+ * Returns whether it was.
  */
-int canvas_draw_line(canvas_t *const canvas, uint32_t x0, uint32_t y0,
+static bool depth_test_px(canvas_t *const canvas, int64_t x, int64_t y,
+                          float key) {
+    enum depth_format format = canvas->depth_format;
+    uint8_t *d = (uint8_t *)canvas->depth +
+                 ((size_t)y * canvas->stride + x) * depth_px_size(format);
+    switch (format) {
+    case DEPTH_F32_REV: {
+        float *stored = (float *)d;
+        if (-key <= *stored)
+            return false;
+        *stored = -key;
+        return true;
+    }
+    case DEPTH_UNORM24: {
+        uint32_t q = depth_unorm(-key, DEPTH_UNORM24_MAX);
+        uint32_t stored = d[0] | (uint32_t)d[1] << 8 | (uint32_t)d[2] << 16;
+        if (q <= stored)
+            return false;
+        d[0] = (uint8_t)q;
+        d[1] = (uint8_t)(q >> 8);
+        d[2] = (uint8_t)(q >> 16);
+        return true;
+    }
+    case DEPTH_UNORM16: {
+        uint16_t *stored = (uint16_t *)d;
+        uint32_t q = depth_unorm(-key, DEPTH_UNORM16_MAX);
+        if (q <= *stored)
+            return false;
+        *stored = (uint16_t)q;
+        return true;
+    }
+    case DEPTH_F32:
+    default: {
+        float *stored = (float *)d;
+        if (key >= *stored)
+            return false;
+        *stored = key;
+        return true;
+    }
+    }
+}
+
+static void tri_interp_rgb_depth(canvas_t *const canvas, int64_t x, int64_t y,
+                                 float u, float v, float w, void *ctx) {
+    const struct tri_shader *shader = ctx;
+    const float *depth = shader->depth;
+    float z = depth[0] * u + depth[1] * v + depth[2] * w;
+
+    struct rgba color;
+    const struct vec3f *wt = shader->weights;
+    if (wt) {
+        color = color_lerp_rgb(u * wt[0].x + v * wt[1].x + w * wt[2].x,
+                               u * wt[0].y + v * wt[1].y + w * wt[2].y,
+                               u * wt[0].z + v * wt[1].z + w * wt[2].z);
+    } else {
+        color = color_lerp_rgb(u, v, w);
+    }
+
+    if (depth_test_px(canvas, x, y, z))
+        canvas_blend_px(canvas, x, y, color);
+}
+
+#if SIMD_LANES > 1
+
+// The same conversion as color_lerp_rgb: widen to double, scale, truncate.
+static inline vi32 lanes_unorm8(vf32 t) {
+    return __builtin_convertvector(__builtin_convertvector(t, vf64) * 255.,
+                                   vi32);
+}
+
+// depth_unorm for every lane
+static inline vi32 lanes_depth_unorm(vf32 r, uint32_t max) {
+    vf32 one = {0};
+    one += 1.f;
+    r = (vf32)((vi32)r & ~(r < 0));
+    vi32 over = r > 1;
+    r = (vf32)(((vi32)r & ~over) | ((vi32)one & over));
+    vi32 q = __builtin_convertvector(r * (float)max + 0.5f, vi32);
+    vi32 top = {0};
+    top += (int32_t)max;
+    over = q > top;
+    return (q & ~over) | (top & over);
+}
+
+/**
+ * depth_test_px for a block of SIMD_LANES depths in format starting at depth.
+ * Returns mask with the lanes that failed cleared.
+ */
+static inline vi32 lanes_depth_test(enum depth_format format, void *depth,
+                                    vf32 key, vi32 mask) {
+    if (format == DEPTH_F32 || format == DEPTH_F32_REV) {
+        vf32 stored;
+        memcpy(&stored, depth, sizeof(stored));
+        if (format == DEPTH_F32) {
+            mask &= ~(key >= stored);
+        } else {
+            key = -key;
+            mask &= ~(key <= stored);
+        }
+        stored = (vf32)(((vi32)key & mask) | ((vi32)stored & ~mask));
+        memcpy(depth, &stored, sizeof(stored));
+        return mask;
+    }
+
+    // The unorm formats have no vector load of their width, so gather them
+    vi32 stored;
+    vi32 q;
+    uint8_t *d = depth;
+    if (format == DEPTH_UNORM24) {
+        q = lanes_depth_unorm(-key, DEPTH_UNORM24_MAX);
+        for (int i = 0; i < SIMD_LANES; i++)
+            stored[i] = d[3 * i] | d[3 * i + 1] << 8 | d[3 * i + 2] << 16;
+    } else {
+        uint16_t in[SIMD_LANES];
+        memcpy(in, d, sizeof(in));
+        q = lanes_depth_unorm(-key, DEPTH_UNORM16_MAX);
+        for (int i = 0; i < SIMD_LANES; i++)
+            stored[i] = in[i];
+    }
+
+    mask &= q > stored;
+    stored = (q & mask) | (stored & ~mask);
+
+    if (format == DEPTH_UNORM24) {
+        for (int i = 0; i < SIMD_LANES; i++) {
+            d[3 * i] = (uint8_t)stored[i];
+            d[3 * i + 1] = (uint8_t)(stored[i] >> 8);
+            d[3 * i + 2] = (uint8_t)(stored[i] >> 16);
+        }
+    } else {
+        uint16_t out[SIMD_LANES];
+        for (int i = 0; i < SIMD_LANES; i++)
+            out[i] = (uint16_t)stored[i];
+        memcpy(d, out, sizeof(out));
+    }
+    return mask;
+}
+
+/**
+ * Shades one block of SIMD_LANES pixels starting at px (and depth, in
+ * format). Lanes with a zero mask are written back unchanged.
+ */
+static inline void tri_shade_block(const struct tri_shader *const shader,
+                                   struct rgba *px, void *depth,
+                                   enum depth_format format, vi32 mask,
+                                   vi32 w0, vi32 w1, vi32 w2, float inv_area) {
+    vi32 dst;
+    memcpy(&dst, px, sizeof(dst));
+
+    vi32 color;
+    if (shader->mode == TRI_SHADE_FLAT) {
+        struct lanes_color c = lanes_color_init(shader->color);
+        color = (vi32)lanes_blend_color(&c, (vu32)dst);
+    } else {
+        vf32 u = __builtin_convertvector(w0, vf32) * inv_area;
+        vf32 v = __builtin_convertvector(w1, vf32) * inv_area;
+        vf32 w = __builtin_convertvector(w2, vf32) * inv_area;
+
+        if (shader->mode == TRI_SHADE_RGB_DEPTH) {
+            const float *key = shader->depth;
+            vf32 z = key[0] * u + key[1] * v;
+            z = z + key[2] * w;
+            mask = lanes_depth_test(format, depth, z, mask);
+        }
+
+        const struct vec3f *wt = shader->weights;
+        if (wt) {
+            vf32 cu = u * wt[0].x + v * wt[1].x;
+            vf32 cv = u * wt[0].y + v * wt[1].y;
+            vf32 cw = u * wt[0].z + v * wt[1].z;
+            u = cu + w * wt[2].x;
+            v = cv + w * wt[2].y;
+            w = cw + w * wt[2].z;
+        }
+
+        // Alpha is 255, so blending is a plain store
+        color = lanes_unorm8(u) | lanes_unorm8(v) << 8 |
+                lanes_unorm8(w) << 16 | (int32_t)0xFF000000;
+    }
+
+    dst = (color & mask) | (dst & ~mask);
+    memcpy(px, &dst, sizeof(dst));
+}
+
+/**
+ * Like tri_raster_rows, but covers each row SIMD_LANES pixels at a time, each
+ * lane a 32-bit edge value. Blocks may run past end_x with those lanes masked
+ * off, as long as they stay inside the clip rectangle; the rest of the row is
+ * finished by the scalar callback.
+ */
+static void tri_raster_blocks(canvas_t *const canvas,
+                              const struct tri_setup *const t, int64_t clip_x1,
+                              const struct tri_shader *const shader,
+                              barycentric_callback_t callback, void *ctx) {
+    const struct tri_edge *e = t->e;
+    vi32 lane;
+    for (int i = 0; i < SIMD_LANES; i++)
+        lane[i] = i;
+
+    vi32 step0 = lane * e[0].step_x;
+    vi32 step1 = lane * e[1].step_x;
+    vi32 step2 = lane * e[2].step_x;
+
+    enum depth_format format = canvas->depth_format;
+    size_t depth_size = depth_px_size(format);
+    int32_t row0 = t->row[0], row1 = t->row[1], row2 = t->row[2];
+    for (int64_t iy = t->start_y; iy <= t->end_y; iy++) {
+        struct rgba *line = &canvas->data[iy * canvas->stride];
+        uint8_t *depth_line =
+            canvas->depth ? (uint8_t *)canvas->depth +
+                                (size_t)iy * canvas->stride * depth_size
+                          : NULL;
+        int32_t w0 = row0, w1 = row1, w2 = row2;
+        int64_t ix = t->start_x;
+
+        for (; ix <= t->end_x && ix + SIMD_LANES - 1 <= clip_x1;
+             ix += SIMD_LANES) {
+            vi32 bw0 = w0 + step0;
+            vi32 bw1 = w1 + step1;
+            vi32 bw2 = w2 + step2;
+            vi32 mask = (bw0 + e[0].bias >= 0) & (bw1 + e[1].bias >= 0) &
+                        (bw2 + e[2].bias >= 0) &
+                        (lane <= (int32_t)(t->end_x - ix));
+
+            bool any = false;
+            for (int i = 0; i < SIMD_LANES; i++)
+                any |= mask[i] != 0;
+            if (any) {
+                tri_shade_block(shader, &line[ix],
+                                depth_line ? depth_line + ix * depth_size
+                                           : NULL,
+                                format, mask, bw0, bw1, bw2, t->inv_area);
+            }
+
+            w0 += SIMD_LANES * e[0].step_x;
+            w1 += SIMD_LANES * e[1].step_x;
+            w2 += SIMD_LANES * e[2].step_x;
+        }
+
+        for (; ix <= t->end_x; ix++) {
+            if ((w0 + e[0].bias) >= 0 && (w1 + e[1].bias) >= 0 &&
+                (w2 + e[2].bias) >= 0) {
+                callback(canvas, ix, iy, (float)w0 * t->inv_area,
+                         (float)w1 * t->inv_area, (float)w2 * t->inv_area,
+                         ctx);
+            }
+            w0 += e[0].step_x;
+            w1 += e[1].step_x;
+            w2 += e[2].step_x;
+        }
+
+        row0 += e[0].step_y;
+        row1 += e[1].step_y;
+        row2 += e[2].step_y;
+    }
+}
+
+#endif // SIMD_LANES > 1
+
+/**
+ * Rasterizes the part of triangle (v1, v2, v3) inside the clip rectangle with
+ * one of the built-in shaders. The result is identical to tri_raster with the
+ * matching callback.
+ */
+static int tri_raster_direct(canvas_t *const canvas, struct vec2fx v1,
+                             struct vec2fx v2, struct vec2fx v3,
+                             int64_t clip_x0, int64_t clip_y0, int64_t clip_x1,
+                             int64_t clip_y1,
+                             const struct tri_shader *const shader) {
+    barycentric_callback_t callback;
+    void *ctx = NULL;
+    switch (shader->mode) {
+    case TRI_SHADE_FLAT:
+        callback = &tri_fill_at_point;
+        ctx = (void *)&shader->color;
+        break;
+    case TRI_SHADE_RGB:
+        callback = &tri_interp_rgb;
+        break;
+    case TRI_SHADE_RGB_DEPTH:
+    default:
+        callback = &tri_interp_rgb_depth;
+        ctx = (void *)shader;
+        break;
+    }
+
+    struct tri_setup t;
+    int ret = tri_setup_init(&t, v1, v2, v3, clip_x0, clip_y0, clip_x1,
+                             clip_y1);
+    if (ret == -ERANGE)
+        return tri_raster_wide(canvas, v1, v2, v3, clip_x0, clip_y0, clip_x1,
+                               clip_y1, callback, ctx);
+    if (ret < 0)
+        return ret;
+
+#if SIMD_LANES > 1
+    tri_raster_blocks(canvas, &t, clip_x1, shader, callback, ctx);
+#else
+    tri_raster_rows(canvas, &t, callback, ctx);
+#endif
+    return 0;
+}
+
+// Tiles of different binner tiles must never share a coarse depth entry
+_Static_assert(BINNER_TILE_SIZE % HIZ_TILE_SIZE == 0,
+               "binner tiles must be made of whole Hi-Z tiles");
+
+static bool tri_covers_rect(const struct tri_setup *const t, struct vec2fx v1,
+                            struct vec2fx v2, struct vec2fx v3, int64_t x0,
+                            int64_t y0, int64_t x1, int64_t y1) {
+    const struct vec2fx anchor[3] = {v2, v3, v1};
+    for (int i = 0; i < 3; i++) {
+        const struct tri_edge e = t->e[i];
+        if (tri_edge_eval(e, anchor[i], x0, y0) + e.bias < 0 ||
+            tri_edge_eval(e, anchor[i], x1, y0) + e.bias < 0 ||
+            tri_edge_eval(e, anchor[i], x0, y1) + e.bias < 0 ||
+            tri_edge_eval(e, anchor[i], x1, y1) + e.bias < 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * tri_raster_direct with a coarse depth test first: HIZ_TILE_SIZE tiles whose
+ * farthest stored depth is nearer than the nearest vertex are skipped, and
+ * the remaining runs of tiles in each tile row are rasterized together.
+ *
+ * Depth writes only ever move a tile nearer, so its entry stays a valid bound
+ * without rescanning. When the triangle covers a whole tile, every pixel ends
+ * up no farther than the farthest vertex, which tightens the bound.
+ */
+static int tri_raster_hiz(canvas_t *const canvas, struct vec2fx v1,
+                          struct vec2fx v2, struct vec2fx v3, int64_t clip_x0,
+                          int64_t clip_y0, int64_t clip_x1, int64_t clip_y1,
+                          const struct tri_shader *const shader) {
+    struct tri_setup t;
+    int ret = tri_setup_init(&t, v1, v2, v3, clip_x0, clip_y0, clip_x1,
+                             clip_y1);
+    if (ret == -ERANGE) { // Too large for the tile test, rarely worth it
+        tri_resolve_box(canvas, v1, v2, v3, clip_x0, clip_y0, clip_x1,
+                        clip_y1, CLEAR_COLOR | CLEAR_DEPTH);
+        return tri_raster_direct(canvas, v1, v2, v3, clip_x0, clip_y0,
+                                 clip_x1, clip_y1, shader);
+    }
+    if (ret < 0)
+        return ret;
+
+    // Interpolated depth can miss the vertex range by a few ulps, and stored
+    // depth by up to a quantum
+    const float *key = shader->depth;
+    float z_abs = MAX(MAX(fabsf(key[0]), fabsf(key[1])), fabsf(key[2]));
+    float z_eps =
+        z_abs * 8 * FLT_EPSILON + depth_quantum(canvas->depth_format);
+    float z_near = MIN(MIN(key[0], key[1]), key[2]) - z_eps;
+    float z_far = MAX(MAX(key[0], key[1]), key[2]) + z_eps;
+
+    uint64_t culled = 0;
+    bool drawn = false;
+    for (int64_t ty = t.start_y / HIZ_TILE_SIZE; ty <= t.end_y / HIZ_TILE_SIZE;
+         ty++) {
+        int64_t tile_y0 = ty * HIZ_TILE_SIZE;
+        int64_t tile_y1 = MIN(tile_y0 + HIZ_TILE_SIZE, canvas->height) - 1;
+        int64_t row_y0 = MAX(tile_y0, t.start_y);
+        int64_t row_y1 = MIN(tile_y1, t.end_y);
+        int64_t run_x0 = -1, run_x1 = -1;
+
+        for (int64_t tx = t.start_x / HIZ_TILE_SIZE;
+             tx <= t.end_x / HIZ_TILE_SIZE; tx++) {
+            int64_t tile_x0 = tx * HIZ_TILE_SIZE;
+            int64_t tile_x1 = MIN(tile_x0 + HIZ_TILE_SIZE, canvas->width) - 1;
+            int64_t col_x0 = MAX(tile_x0, t.start_x);
+            int64_t col_x1 = MIN(tile_x1, t.end_x);
+            float *tile_max = &canvas->depth_tiles[ty * canvas->depth_tiles_x + tx];
+
+            bool hidden = z_near >= *tile_max;
+            if (hidden) {
+                culled += (col_x1 - col_x0 + 1) * (row_y1 - row_y0 + 1);
+            } else {
+                if (canvas->clear_tiles)
+                    clear_tile_touch(canvas, (uint32_t)tx, (uint32_t)ty,
+                                     CLEAR_COLOR | CLEAR_DEPTH);
+                if (canvas->dirty_tiles)
+                    dirty_tile_mark(canvas, (uint32_t)tx, (uint32_t)ty);
+                if (z_far < *tile_max &&
+                    tri_covers_rect(&t, v1, v2, v3, tile_x0, tile_y0, tile_x1,
+                                    tile_y1))
+                    *tile_max = z_far;
+                if (run_x0 < 0)
+                    run_x0 = col_x0;
+                run_x1 = MIN(tile_x1, clip_x1);
+            }
+
+            if (run_x0 >= 0 && (hidden || tx == t.end_x / HIZ_TILE_SIZE)) {
+                tri_raster_direct(canvas, v1, v2, v3, run_x0, row_y0, run_x1,
+                                  row_y1, shader);
+                drawn = true;
+                run_x0 = -1;
+            }
+        }
+    }
+
+    if (culled) {
+        struct depth_stats *stats = &canvas->depth_stats;
+        __atomic_fetch_add(&stats->pixels_culled, culled, __ATOMIC_RELAXED);
+        if (!drawn)
+            __atomic_fetch_add(&stats->tris_culled, 1, __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+static int tri_raster_shaded(canvas_t *const canvas, struct vec2fx v1,
+                             struct vec2fx v2, struct vec2fx v3,
+                             int64_t clip_x0, int64_t clip_y0, int64_t clip_x1,
+                             int64_t clip_y1,
+                             const struct tri_shader *const shader) {
+    // The coarse depth test resolves only the tiles it does not skip
+    if (shader->mode == TRI_SHADE_RGB_DEPTH && canvas->depth_tiles)
+        return tri_raster_hiz(canvas, v1, v2, v3, clip_x0, clip_y0, clip_x1,
+                              clip_y1, shader);
+    tri_resolve_box(canvas, v1, v2, v3, clip_x0, clip_y0, clip_x1, clip_y1,
+                    shader->mode == TRI_SHADE_RGB_DEPTH
+                        ? CLEAR_COLOR | CLEAR_DEPTH
+                        : CLEAR_COLOR);
+    return tri_raster_direct(canvas, v1, v2, v3, clip_x0, clip_y0, clip_x1,
+                             clip_y1, shader);
+}
+
+/**
+ * Shades the triangle (v1, v2, v3), clipped to the canvas. Vertices may lie up
+ * to GUARD_BAND pixels off the canvas.
+ */
+static int canvas_shade_tri(canvas_t *const canvas, point2_t v1, point2_t v2,
+                            point2_t v3, const struct tri_shader *const shader) {
+    if (!tri_in_guard_band(canvas, v1, v2, v3))
+        return -EDOM;
+
+    return tri_raster_shaded(canvas, vec2fx_from_px(v1), vec2fx_from_px(v2),
+                             vec2fx_from_px(v3), 0, 0, canvas->width - 1,
+                             canvas->height - 1, shader);
+}
+
+int canvas_fill_tri(canvas_t *const canvas, int64_t x0, int64_t y0, int64_t x1,
+                    int64_t y1, int64_t x2, int64_t y2, struct rgba color) {
+    point2_t v1 = {x0, y0};
+    point2_t v2 = {x1, y1};
+    point2_t v3 = {x2, y2};
+    struct tri_shader shader = {.mode = TRI_SHADE_FLAT, .color = color};
+    return canvas_shade_tri(canvas, v1, v2, v3, &shader);
+}
+
+void canvas_fill_triInterpolated(canvas_t *const canvas, point2_t v1,
+                                 point2_t v2, point2_t v3) {
+    struct tri_shader shader = {.mode = TRI_SHADE_RGB};
+    canvas_shade_tri(canvas, v1, v2, v3, &shader);
+}
+
+int canvas_fill_quad(canvas_t *const canvas, point2_t p1, point2_t p2,
+                     point2_t p3, point2_t p4, struct rgba color) {
+    // We require the quad to be sorted for now.
+    assert(p1.x < p2.x && p1.x < p3.x && p1.x < p4.x);
+    assert(p4.x > p3.x && p4.x > p2.x && p4.x > p1.x);
+
+    int ret;
+    ret = canvas_fill_tri(canvas, p1.x, p1.y, p2.x, p2.y, p3.x, p3.y, color);
+    if (ret < 0)
+        return ret;
+    ret = canvas_fill_tri(canvas, p4.x, p4.y, p2.x, p2.y, p3.x, p3.y, color);
+    if (ret < 0)
+        return ret;
+    return 0;
+}
+
+/**
+ * Blends one pixel of a line if it lies within clip. A pixel off the canvas
+ * fails like canvas_blend_px, which ends the line, whatever the clip.
+ */
+static inline int line_blend_px(canvas_t *const canvas, uint32_t x,
+                                uint32_t y, struct rgba color,
+                                struct clip_rect clip) {
+    if (!canvas_point_in_range(canvas, x, y))
+        return -EDOM;
+    if (x < clip.x0 || x > clip.x1 || y < clip.y0 || y > clip.y1)
+        return 0;
+    return canvas_blend_px(canvas, x, y, color);
+}
+
+static int line_draw(canvas_t *const canvas, uint32_t x0, uint32_t y0,
                      uint32_t x1, uint32_t y1, struct rgba color,
-                     uint32_t thiccness) {
+                     uint32_t thiccness, struct clip_rect clip) {
     int ret;
     uint32_t start_x = x0;
     uint32_t start_y = y0;
@@ -348,7 +2216,7 @@ int canvas_draw_line(canvas_t *const canvas, uint32_t x0, uint32_t y0,
             for (uint32_t x = start_x; x < thiccness + start_x; x++) {
                 if (IN_XRANGE(x, 0, canvas->width) &&
                     IN_XRANGE(iy, 0, canvas->height)) {
-                    ret = canvas_blend_px(canvas, x, iy, color);
+                    ret = line_blend_px(canvas, x, iy, color, clip);
                     if (ret < 0)
                         return ret;
                 }
@@ -368,295 +2236,3521 @@ int canvas_draw_line(canvas_t *const canvas, uint32_t x0, uint32_t y0,
     float m = dy / dx;
     float b = (float)start_y - m * (float)start_x;
 
-    for (uint32_t ix = start_x; ix <= end_x; ix++) {
-        float real_y = m * (float)ix + b;
-        uint32_t ry0 = (uint32_t)(real_y - (m / 2.));
-        uint32_t ry1 = (uint32_t)(real_y + (m / 2.));
+    for (uint32_t ix = start_x; ix <= end_x; ix++) {
+        float real_y = m * (float)ix + b;
+        uint32_t ry0 = (uint32_t)(real_y - (m / 2.));
+        uint32_t ry1 = (uint32_t)(real_y + (m / 2.));
+
+        if (ry0 > ry1) {
+            SWAP(uint32_t, ry0, ry1);
+        }
+
+        for (uint32_t iy = ry0; iy <= ry1 || (iy < 0 && iy >= canvas->height);
+             iy++) {
+            for (uint32_t x_thicc = ix; x_thicc < ix + thiccness; x_thicc++) {
+
+                if (iy < canvas->height && x_thicc < canvas->width) {
+                    ret = line_blend_px(canvas, x_thicc, iy, color, clip);
+                    if (ret < 0)
+                        return ret;
+                }
+            }
+        }
+
+        for (uint32_t y_thicc = ry0; y_thicc < ry0 + thiccness; y_thicc++) {
+            if (y_thicc < canvas->height && ix < canvas->width) {
+                ret = line_blend_px(canvas, ix, y_thicc, color, clip);
+                if (ret < 0)
+                    return ret;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Draws a line from point (x0, y0) to (x1, y1) of width 1.
+ *
+ * @todo Antialiasing
+ */
+int canvas_draw_line(canvas_t *const canvas, uint32_t x0, uint32_t y0,
+                     uint32_t x1, uint32_t y1, struct rgba color,
+                     uint32_t thiccness) {
+    return line_draw(canvas, x0, y0, x1, y1, color, thiccness,
+                     canvas_clip_rect(canvas));
+}
+
+// 3D
+
+#define CAMERA_NEAR_DEFAULT 1.0f
+#define CAMERA_PLANES 5     // Near, left, right, bottom and top
+#define CLIP_MAX_VERTICES 8 // A triangle clipped by five planes
+
+/**
+ * Receives the projected triangles that make up a camera space triangle
+ * after clipping. weights is NULL for a triangle that needed no clipping.
+ */
+typedef int (*camera_tri_fn)(void *ctx, const struct vec2fx proj[3],
+                             const point3_t vertices[3], float dist,
+                             const struct vec3f *weights);
+
+struct clip_vertex {
+    point3_t p;           // Camera space position
+    struct vec3f weights; // Barycentric weights within the original triangle
+};
+
+// Inside where a * x + b * y + c * (z + cam.dist) + d >= 0
+struct clip_plane {
+    float a, b, c, d;
+};
+
+static inline float clip_plane_dist(struct clip_plane plane, point3_t p,
+                                    float dist) {
+    return plane.a * p.x + plane.b * p.y + plane.c * (p.z + dist) + plane.d;
+}
+
+static struct clip_vertex clip_vertex_lerp(const struct clip_vertex *a,
+                                           const struct clip_vertex *b,
+                                           float t) {
+    return (struct clip_vertex){
+        .p = {lerpf(t, a->p.x, b->p.x), lerpf(t, a->p.y, b->p.y),
+              lerpf(t, a->p.z, b->p.z)},
+        .weights = {lerpf(t, a->weights.x, b->weights.x),
+                    lerpf(t, a->weights.y, b->weights.y),
+                    lerpf(t, a->weights.z, b->weights.z)},
+    };
+}
+
+/**
+ * The planes bounding what projects to within band pixels of the canvas, in
+ * front of the near plane.
+ */
+static void camera_planes(struct camera cam, float near, float band,
+                          struct clip_plane planes[CAMERA_PLANES]) {
+    float f = cam.focal_len;
+    float gx = cam.width / 2.0f + band;
+    float gy = cam.height / 2.0f + band;
+    planes[0] = (struct clip_plane){0, 0, 1, -near}; // z + dist >= near
+    planes[1] = (struct clip_plane){f, 0, gx, 0};    // Projected x >= -band
+    planes[2] = (struct clip_plane){-f, 0, gx, 0}; // Projected x <= width + band
+    planes[3] = (struct clip_plane){0, f, gy, 0}; // Projected y <= height + band
+    planes[4] = (struct clip_plane){0, -f, gy, 0}; // Projected y >= -band
+}
+
+/**
+ * Clips a camera space triangle against the near plane and the guard band
+ * (Sutherland-Hodgman), then projects and emits the remaining polygon as a
+ * triangle fan.
+ */
+static int camera_clip_tri(const point3_t *const vertices, struct camera cam,
+                           float near, camera_tri_fn emit, void *ctx) {
+    struct clip_plane planes[CAMERA_PLANES];
+    camera_planes(cam, near, GUARD_BAND, planes);
+
+    struct clip_vertex poly[2][CLIP_MAX_VERTICES];
+    for (int i = 0; i < 3; i++) {
+        poly[0][i].p = vertices[i];
+        poly[0][i].weights =
+            (struct vec3f){i == 0 ? 1 : 0, i == 1 ? 1 : 0, i == 2 ? 1 : 0};
+    }
+
+    int n = 3;
+    int cur = 0;
+    for (int plane = 0; plane < CAMERA_PLANES && n > 0; plane++) {
+        const struct clip_vertex *in = poly[cur];
+        struct clip_vertex *out = poly[cur ^ 1];
+        int m = 0;
+        for (int i = 0; i < n; i++) {
+            const struct clip_vertex *a = &in[i];
+            const struct clip_vertex *b = &in[(i + 1) % n];
+            float da = clip_plane_dist(planes[plane], a->p, cam.dist);
+            float db = clip_plane_dist(planes[plane], b->p, cam.dist);
+            if (da >= 0)
+                out[m++] = *a;
+            if ((da >= 0) != (db >= 0))
+                out[m++] = clip_vertex_lerp(a, b, da / (da - db));
+        }
+        n = m;
+        cur ^= 1;
+    }
+
+    if (n < 3)
+        return -EINVAL; // Entirely clipped away
+
+    struct vec2fx proj[CLIP_MAX_VERTICES];
+    for (int i = 0; i < n; i++)
+        proj[i] = point3_proj_fx(poly[cur][i].p, cam);
+
+    int ret = -EINVAL;
+    const struct clip_vertex *v = poly[cur];
+    for (int i = 1; i + 1 < n; i++) {
+        struct vec2fx tri_proj[3] = {proj[0], proj[i], proj[i + 1]};
+        point3_t tri_vertices[3] = {v[0].p, v[i].p, v[i + 1].p};
+        struct vec3f weights[3] = {v[0].weights, v[i].weights,
+                                   v[i + 1].weights};
+        if (emit(ctx, tri_proj, tri_vertices, cam.dist, weights) == 0)
+            ret = 0;
+    }
+    return ret;
+}
+
+/**
+ * Per-camera state for projecting and culling, computed once per draw.
+ */
+struct camera_setup {
+    struct camera cam;
+    float near;
+
+    // The frustum planes, with a pixel of slack for the rounding of projected
+    // vertices
+    struct clip_plane frustum[CAMERA_PLANES];
+};
+
+/**
+ * A camera space vertex with everything culling and projection need to know
+ * about it, so that vertices shared between triangles are handled once.
+ */
+struct camera_vertex {
+    point3_t p;         // Camera space position
+    struct vec2fx proj; // Projected position, unless clip is set
+    uint8_t outside;    // Bit i is set when outside frustum plane i
+    bool clip; // Behind the near plane or projected past the guard band
+};
+
+static void camera_setup_init(struct camera_setup *const setup,
+                              struct camera cam) {
+    setup->cam = cam;
+    setup->near = cam.near > 0 ? cam.near : CAMERA_NEAR_DEFAULT;
+    camera_planes(cam, setup->near, 1, setup->frustum);
+}
+
+static void camera_vertex_init(const struct camera_setup *const setup,
+                               point3_t p, struct camera_vertex *const v) {
+    const struct camera cam = setup->cam;
+    v->p = p;
+    v->outside = 0;
+    for (int plane = 0; plane < CAMERA_PLANES; plane++) {
+        if (clip_plane_dist(setup->frustum[plane], p, cam.dist) < 0)
+            v->outside |= 1 << plane;
+    }
+
+    v->clip = p.z + cam.dist < setup->near;
+    if (v->clip)
+        return;
+
+    double x, y;
+    point3_proj_xy(p, cam, &x, &y);
+    v->clip = !(x >= -GUARD_BAND && x < cam.width + GUARD_BAND &&
+                y >= -GUARD_BAND && y < cam.height + GUARD_BAND);
+    v->proj = (struct vec2fx){fx_from_double(x), fx_from_double(y)};
+}
+
+/**
+ * Whether a projected triangle with the given signed area is dropped by the
+ * camera's cull mode. A positive area is clockwise on the canvas.
+ */
+static inline bool camera_winding_culled(struct camera cam, double area) {
+    return (cam.cull == CULL_CW && area > 0) ||
+           (cam.cull == CULL_CCW && area < 0);
+}
+
+/**
+ * The projected winding of a camera space triangle, computed without
+ * projecting so that it holds for triangles crossing the near plane. Its sign
+ * matches the projected area of the parts in front of the camera.
+ */
+static double camera_tri_winding(const point3_t *const vertices,
+                                 struct camera cam) {
+    double p[3][3];
+    for (int i = 0; i < 3; i++) {
+        p[i][0] = vertices[i].x;
+        p[i][1] = vertices[i].y;
+        p[i][2] = vertices[i].z + cam.dist;
+    }
+
+    // y is flipped by the projection, which flips the winding
+    return -(p[0][0] * (p[1][1] * p[2][2] - p[1][2] * p[2][1]) -
+             p[0][1] * (p[1][0] * p[2][2] - p[1][2] * p[2][0]) +
+             p[0][2] * (p[1][0] * p[2][1] - p[1][1] * p[2][0]));
+}
+
+/**
+ * Culls and projects the triangle (a, b, c). Triangles outside the frustum,
+ * facing away under cam.cull or of zero area are dropped and counted in
+ * stats. Triangles that need no clipping are emitted as they are; the rest go
+ * through camera_clip_tri.
+ */
+static int camera_tri_vertices(const struct camera_setup *const setup,
+                               const struct camera_vertex *const a,
+                               const struct camera_vertex *const b,
+                               const struct camera_vertex *const c,
+                               struct cull_stats *const stats,
+                               camera_tri_fn emit, void *ctx) {
+    if (a->outside & b->outside & c->outside) {
+        stats->frustum++;
+        return -EINVAL;
+    }
+
+    // Unclipped triangles are judged by their snapped vertices, exactly as
+    // the rasterizer would see them
+    const point3_t vertices[3] = {a->p, b->p, c->p};
+    bool clip = a->clip || b->clip || c->clip;
+    double winding;
+    if (!clip) {
+        int64_t abx = b->proj.x - a->proj.x, aby = b->proj.y - a->proj.y;
+        int64_t acx = c->proj.x - a->proj.x, acy = c->proj.y - a->proj.y;
+        winding = (double)(abx * acy - aby * acx);
+    } else {
+        winding = camera_tri_winding(vertices, setup->cam);
+    }
+
+    if (winding == 0) {
+        stats->degenerate++;
+        return -EDOM;
+    }
+    if (camera_winding_culled(setup->cam, winding)) {
+        stats->backface++;
+        return -EINVAL;
+    }
+
+    if (clip)
+        return camera_clip_tri(vertices, setup->cam, setup->near, emit, ctx);
+    const struct vec2fx proj[3] = {a->proj, b->proj, c->proj};
+    return emit(ctx, proj, vertices, setup->cam.dist, NULL);
+}
+
+static int camera_tri(const point3_t *const vertices, struct camera cam,
+                      struct cull_stats *const stats, camera_tri_fn emit,
+                      void *ctx) {
+    struct camera_setup setup;
+    camera_setup_init(&setup, cam);
+
+    struct camera_vertex v[3];
+    for (int i = 0; i < 3; i++)
+        camera_vertex_init(&setup, vertices[i], &v[i]);
+    return camera_tri_vertices(&setup, &v[0], &v[1], &v[2], stats, emit, ctx);
+}
+
+/**
+ * Transforms
+ */
+
+/**
+ * The model transform that moves origin to (0, 0, 0), scales by scale and
+ * rotates by theta around the y axis, in the direction of point3_rotate.
+ */
+struct transform transform_model(point3_t origin, float scale, float theta) {
+    float s = sinf(theta) * scale;
+    float c = cosf(theta) * scale;
+    return (struct transform){.m = {
+                                  {c, 0, -s, -(c * origin.x - s * origin.z)},
+                                  {0, scale, 0, -scale * origin.y},
+                                  {s, 0, c, -(s * origin.x + c * origin.z)},
+                              }};
+}
+
+point3_t transform_apply(const struct transform *const t, point3_t p) {
+    const float(*m)[4] = t->m;
+    return (point3_t){
+        m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+        m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+        m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3],
+    };
+}
+
+/**
+ * Meshes
+ *
+ * Every vertex of the mesh is transformed, projected and classified against
+ * the frustum once, into a scratch buffer kept by the canvas. The faces then
+ * only gather their three vertices by index.
+ */
+
+// Screen area, in pixels, lod_select budgets per face
+#define LOD_PIXELS_PER_FACE 8.0
+
+static int mesh_draw(arraylist_t *const scratch, const obj_t *const obj,
+                     const struct transform *const model, struct camera cam,
+                     struct cull_stats *const stats, camera_tri_fn emit,
+                     void *ctx) {
+    size_t vertex_count = obj_vertex_count(obj);
+    if (scratch->capacity < vertex_count) {
+        int ret = ARRAY_RESIZE(struct camera_vertex, scratch, vertex_count);
+        if (ret < 0)
+            return ret;
+    }
+
+    struct camera_setup setup;
+    camera_setup_init(&setup, cam);
+
+    struct camera_vertex *v = scratch->data;
+    for (size_t i = 0; i < vertex_count; i++) {
+        point3_t p = transform_apply(model, obj_vertex(obj, i));
+        camera_vertex_init(&setup, p, &v[i]);
+    }
+    scratch->count = vertex_count;
+
+    int drawn = 0;
+    for (size_t i = 0; i < obj_face_count(obj); i++) {
+        const uint32_t *face = obj_face(obj, i);
+        if (face[0] >= vertex_count || face[1] >= vertex_count ||
+            face[2] >= vertex_count)
+            return -EINVAL;
+
+        if (camera_tri_vertices(&setup, &v[face[0]], &v[face[1]], &v[face[2]],
+                                stats, emit, ctx) == 0)
+            drawn++;
+    }
+    return drawn;
+}
+
+/**
+ * The pixels sampled within the bounding box of the projected triangle,
+ * scissored to the canvas. Returns false when there are none.
+ */
+static bool tri_canvas_box(const canvas_t *const canvas,
+                           const struct vec2fx p[3], int64_t box[4]) {
+    box[0] = MAX(fx_ceil_px(MIN(MIN(p[0].x, p[1].x), p[2].x)), 0);
+    box[1] = MAX(fx_ceil_px(MIN(MIN(p[0].y, p[1].y), p[2].y)), 0);
+    box[2] = MIN(fx_floor_px(MAX(MAX(p[0].x, p[1].x), p[2].x)),
+                 (int64_t)canvas->width - 1);
+    box[3] = MIN(fx_floor_px(MAX(MAX(p[0].y, p[1].y), p[2].y)),
+                 (int64_t)canvas->height - 1);
+    return box[0] <= box[2] && box[1] <= box[3];
+}
+
+static int canvas_emit_tri(void *ctx, const struct vec2fx proj[3],
+                           const point3_t vertices[3], float dist,
+                           const struct vec3f *weights) {
+    canvas_t *canvas = (canvas_t *)ctx;
+    float depth[3];
+    for (int i = 0; i < 3; i++)
+        depth[i] = depth_key(canvas, vertices[i], dist);
+    struct tri_shader shader = {
+        .mode = TRI_SHADE_RGB_DEPTH,
+        .depth = depth,
+        .weights = weights,
+    };
+
+    int64_t box[4];
+    if (!tri_canvas_box(canvas, proj, box))
+        return -EINVAL; // No pixel of it on the canvas
+
+    return tri_raster_shaded(canvas, proj[0], proj[1], proj[2], 0, 0,
+                             canvas->width - 1, canvas->height - 1, &shader);
+}
+
+/**
+ * Projects the camera space triangle and rasterizes it with depth testing.
+ * Triangles crossing the near plane or reaching far off screen are clipped.
+ * Returns -EINVAL if the triangle is culled or nothing of it is on the
+ * canvas, and -EDOM if it has zero area.
+ */
+int canvas_proj_tri(canvas_t *const canvas, point3_t *const vertices,
+                    struct camera cam) {
+    return camera_tri(vertices, cam, &canvas->cull_stats, &canvas_emit_tri,
+                      canvas);
+}
+
+/**
+ * Draws every face of obj with canvas_proj_tri, after moving the mesh into
+ * camera space with model. Returns the number of faces that were drawn, or
+ * -EINVAL if a face refers to a missing vertex.
+ */
+int canvas_draw_mesh(canvas_t *const canvas, const obj_t *const obj,
+                     const struct transform *const model, struct camera cam) {
+    return mesh_draw(&canvas->mesh_scratch, obj, model, cam,
+                     &canvas->cull_stats, &canvas_emit_tri, canvas);
+}
+
+/**
+ * Picks the level of lod to draw with model and cam: the most detailed one
+ * with no more than a face per LOD_PIXELS_PER_FACE pixels of the projected
+ * bounding sphere of the mesh, or the coarsest one. Meshes the camera is
+ * inside of or close to get the full mesh.
+ */
+size_t lod_select(const lod_t *const lod, const struct transform *const model,
+                  struct camera cam) {
+    const obj_t *obj = &lod->levels[0];
+    point3_t lo = obj->bounds_min;
+    point3_t hi = obj->bounds_max;
+    point3_t center = {(lo.x + hi.x) / 2, (lo.y + hi.y) / 2,
+                       (lo.z + hi.z) / 2};
+    float radius = sqrtf((hi.x - lo.x) * (hi.x - lo.x) +
+                         (hi.y - lo.y) * (hi.y - lo.y) +
+                         (hi.z - lo.z) * (hi.z - lo.z)) /
+                   2;
+
+    // The largest scale along any axis of the model
+    const float(*m)[4] = model->m;
+    float scale = 0;
+    for (int j = 0; j < 3; j++) {
+        scale = MAX(scale, sqrtf(m[0][j] * m[0][j] + m[1][j] * m[1][j] +
+                                 m[2][j] * m[2][j]));
+    }
+
+    float near = cam.near > 0 ? cam.near : CAMERA_NEAR_DEFAULT;
+    float depth = transform_apply(model, center).z + cam.dist;
+    radius *= scale;
+    if (depth - radius <= near)
+        return 0;
+
+    double radius_px = radius * cam.focal_len / depth;
+    double budget = M_PI * radius_px * radius_px / LOD_PIXELS_PER_FACE;
+    for (size_t i = 0; i < lod->level_count; i++) {
+        if (obj_face_count(&lod->levels[i]) <= budget)
+            return i;
+    }
+    return lod->level_count - 1;
+}
+
+/**
+ * Draws the level of lod picked by lod_select with canvas_draw_mesh.
+ */
+int canvas_draw_lod(canvas_t *const canvas, const lod_t *const lod,
+                    const struct transform *const model, struct camera cam) {
+    const obj_t *obj = &lod->levels[lod_select(lod, model, cam)];
+    return canvas_draw_mesh(canvas, obj, model, cam);
+}
+
+/**
+ * Tile binning
+ *
+ * Projected triangles are appended to a list and referenced from the bin of
+ * every tile their bounding box touches. binner_flush() then rasterizes the
+ * tiles in parallel, each tile replaying its triangles in submission order
+ * clipped to the tile. Every pixel belongs to exactly one tile, so the result
+ * is identical to calling canvas_proj_tri() for each triangle in turn.
+ *
+ * The 2D draws of a command buffer are binned the same way, by their bounding
+ * box, and replayed clipped to each tile in line with the triangles.
+ */
+
+struct binned_tri {
+    struct vec2fx proj[3];
+    float depth[3]; // depth_key of each vertex
+    struct vec3f weights[3];
+    bool clipped; // Whether weights are in use
+};
+
+// Marks a bin entry as an index into the queued draw_cmds rather than tris
+#define BIN_CMD (1u << 31)
+
+enum draw_cmd_type {
+    DRAW_FILL,      // canvas_fill
+    DRAW_RECT,      // canvas_fill_rect
+    DRAW_CIRCLE,    // canvas_fill_circle
+    DRAW_CIRCLE_AA, // canvas_fill_circle_aa
+    DRAW_TRI,       // canvas_fill_tri
+    DRAW_LINE,      // canvas_draw_line
+    DRAW_TEXT,      // canvas_write_string
+    DRAW_MESH,      // canvas_draw_mesh
+};
+
+/**
+ * A draw call recorded by a command buffer, with the arguments of the
+ * canvas_* function it stands for.
+ */
+struct draw_cmd {
+    enum draw_cmd_type type;
+    struct rgba color;
+    union {
+        struct {
+            uint32_t x, y, width, height;
+        } rect;
+        struct {
+            int64_t x, y;
+            uint32_t radius;
+        } circle;
+        point2_t tri[3];
+        struct {
+            uint32_t x0, y0, x1, y1, thiccness;
+        } line;
+        struct {
+            const char *str; // Set when queued, as text may move until then
+            size_t offset;   // Of the first character in cmd_buffer.text
+            uint32_t len, x, y, font_size;
+            font_t font;
+        } text;
+        struct {
+            const obj_t *obj;
+            struct transform model;
+            struct camera cam;
+        } mesh;
+    };
+};
+
+/**
+ * Conservative bounds of the pixels cmd may draw to, before clipping to the
+ * canvas. Returns false if it draws nothing.
+ */
+static bool draw_cmd_bounds(const canvas_t *const canvas,
+                            const struct draw_cmd *const cmd,
+                            struct clip_rect *box) {
+    switch (cmd->type) {
+    case DRAW_FILL:
+        *box = canvas_clip_rect(canvas);
+        return true;
+    case DRAW_RECT:
+        *box = fill_rect_bounds(canvas, cmd->rect.x, cmd->rect.y,
+                                cmd->rect.width, cmd->rect.height);
+        return true;
+    case DRAW_CIRCLE:
+    case DRAW_CIRCLE_AA: {
+        int64_t r = (int64_t)cmd->circle.radius + 1;
+        *box = (struct clip_rect){cmd->circle.x - r, cmd->circle.y - r,
+                                  cmd->circle.x + r, cmd->circle.y + r};
+        return true;
+    }
+    case DRAW_TRI: {
+        const point2_t *v = cmd->tri;
+        if (!tri_in_guard_band(canvas, v[0], v[1], v[2]))
+            return false;
+        *box = (struct clip_rect){MIN(MIN(v[0].x, v[1].x), v[2].x),
+                                  MIN(MIN(v[0].y, v[1].y), v[2].y),
+                                  MAX(MAX(v[0].x, v[1].x), v[2].x),
+                                  MAX(MAX(v[0].y, v[1].y), v[2].y)};
+        return true;
+    }
+    case DRAW_LINE: {
+        // Each column of a sloped line reaches half its slope past the line
+        int64_t x0 = cmd->line.x0, y0 = cmd->line.y0;
+        int64_t x1 = cmd->line.x1, y1 = cmd->line.y1;
+        int64_t reach = 0;
+        if (x0 != x1) {
+            double m = (double)(y1 - y0) / (double)(x1 - x0);
+            reach = (int64_t)(fabs(m) / 2) + 2;
+        }
+        *box = (struct clip_rect){MIN(x0, x1), MIN(y0, y1) - reach,
+                                  MAX(x0, x1) + cmd->line.thiccness,
+                                  MAX(y0, y1) + reach + cmd->line.thiccness};
+        return true;
+    }
+    case DRAW_TEXT: {
+        int64_t glyph_w = cmd->text.font_size * cmd->text.font.glyph_width;
+        int64_t glyph_h = cmd->text.font_size * cmd->text.font.glyph_height;
+        *box = (struct clip_rect){cmd->text.x, cmd->text.y,
+                                  cmd->text.x + cmd->text.len * glyph_w,
+                                  cmd->text.y + glyph_h};
+        return cmd->text.len > 0;
+    }
+    case DRAW_MESH:
+    default:
+        return false; // Queued as triangles
+    }
+}
+
+static void char_draw(canvas_t *const canvas, char c, uint32_t x, uint32_t y,
+                      font_t font, uint32_t font_size, struct rgba color,
+                      struct clip_rect clip);
+
+/**
+ * Runs the 2D draw cmd with everything outside clip left alone.
+ */
+static void draw_cmd_run(canvas_t *const canvas,
+                         const struct draw_cmd *const cmd,
+                         struct clip_rect clip) {
+    switch (cmd->type) {
+    case DRAW_FILL:
+        canvas_resolve_rect(canvas, clip.x0, clip.y0, clip.x1, clip.y1,
+                            CLEAR_COLOR, true);
+        for (int64_t y = clip.y0; y <= clip.y1; y++)
+            span_set(&canvas->data[y * canvas->stride + clip.x0],
+                     clip.x1 - clip.x0 + 1, cmd->color);
+        break;
+    case DRAW_RECT: {
+        struct clip_rect r = fill_rect_bounds(canvas, cmd->rect.x, cmd->rect.y,
+                                              cmd->rect.width,
+                                              cmd->rect.height);
+        rect_blend(canvas, r.x0, r.y0, r.x1, r.y1, cmd->color, clip);
+        break;
+    }
+    case DRAW_CIRCLE:
+        circle_fill(canvas, cmd->circle.x, cmd->circle.y, cmd->circle.radius,
+                    cmd->color, clip);
+        break;
+    case DRAW_CIRCLE_AA:
+        circle_fill_aa(canvas, cmd->circle.x, cmd->circle.y,
+                       cmd->circle.radius, cmd->color, clip);
+        break;
+    case DRAW_TRI: {
+        struct tri_shader shader = {.mode = TRI_SHADE_FLAT,
+                                    .color = cmd->color};
+        tri_raster_shaded(canvas, vec2fx_from_px(cmd->tri[0]),
+                          vec2fx_from_px(cmd->tri[1]),
+                          vec2fx_from_px(cmd->tri[2]), clip.x0, clip.y0,
+                          clip.x1, clip.y1, &shader);
+        break;
+    }
+    case DRAW_LINE:
+        line_draw(canvas, cmd->line.x0, cmd->line.y0, cmd->line.x1,
+                  cmd->line.y1, cmd->color, cmd->line.thiccness, clip);
+        break;
+    case DRAW_TEXT:
+        for (uint32_t i = 0; i < cmd->text.len; i++) {
+            uint32_t x = cmd->text.x +
+                         i * cmd->text.font_size * cmd->text.font.glyph_width;
+            char_draw(canvas, cmd->text.str[i], x, cmd->text.y,
+                      cmd->text.font, cmd->text.font_size, cmd->color, clip);
+        }
+        break;
+    case DRAW_MESH:
+    default:
+        break;
+    }
+}
+
+/**
+ * Tiles start on the HIZ_TILE_SIZE grid of the root canvas, even for a view
+ * off that grid, so that no two tiles share a clear or dirty tile of the root
+ * and threads drawing neighbouring tiles never resolve the same clear.
+ */
+static inline uint32_t binner_tile_count(uint32_t px, uint32_t offset) {
+    return (px + offset + BINNER_TILE_SIZE - 1) / BINNER_TILE_SIZE;
+}
+
+/**
+ * On failure, whatever was allocated is released again.
+ */
+int binner_init(binner_t *const binner, canvas_t *const canvas,
+                uint32_t thread_count) {
+    uint32_t offset_x = canvas->origin_x % HIZ_TILE_SIZE;
+    uint32_t offset_y = canvas->origin_y % HIZ_TILE_SIZE;
+    *binner = (binner_t){
+        .canvas = canvas,
+        .tiles_x = binner_tile_count(canvas->width, offset_x),
+        .tiles_y = binner_tile_count(canvas->height, offset_y),
+        .offset_x = offset_x,
+        .offset_y = offset_y,
+    };
+
+    int ret = ARRAY_MAKE(&binner->tris, struct binned_tri, 1024);
+    if (ret == 0)
+        ret = ARRAY_MAKE(&binner->cmds, struct draw_cmd, 64);
+
+    size_t tile_count = (size_t)binner->tiles_x * binner->tiles_y;
+    if (ret == 0) {
+        binner->bins = heap_calloc(tile_count, sizeof(arraylist_t));
+        if (!binner->bins)
+            ret = -ENOMEM;
+    }
+    for (size_t i = 0; ret == 0 && i < tile_count; i++)
+        ret = ARRAY_MAKE(&binner->bins[i], uint32_t, 64);
+
+    if (ret == 0)
+        ret = pool_init(&binner->pool, thread_count);
+    if (ret < 0)
+        binner_cleanup(binner);
+    return ret;
+}
+
+/**
+ * Points the binner at another canvas of the same size and the same offset
+ * from the HIZ_TILE_SIZE grid of its root, such as the next buffer of a swap
+ * chain. Nothing may be queued.
+ */
+int binner_set_canvas(binner_t *const binner, canvas_t *const canvas) {
+    if (canvas->width != binner->canvas->width ||
+        canvas->height != binner->canvas->height ||
+        canvas->origin_x % HIZ_TILE_SIZE != binner->offset_x ||
+        canvas->origin_y % HIZ_TILE_SIZE != binner->offset_y ||
+        binner->tris.count > 0 || binner->cmds.count > 0)
+        return -EINVAL;
+    binner->canvas = canvas;
+    return 0;
+}
+
+static int binner_emit_tri(void *ctx, const struct vec2fx proj[3],
+                           const point3_t vertices[3], float dist,
+                           const struct vec3f *weights) {
+    binner_t *binner = (binner_t *)ctx;
+    canvas_t *canvas = binner->canvas;
+    const struct vec2fx *p = proj;
+    if ((int64_t)(p[1].x - p[0].x) * (p[2].y - p[0].y) ==
+        (int64_t)(p[1].y - p[0].y) * (p[2].x - p[0].x))
+        return -EDOM; // no degenerate triangles
+
+    int64_t box[4];
+    if (!tri_canvas_box(canvas, proj, box))
+        return -EINVAL;
+    int64_t x0 = box[0], y0 = box[1], x1 = box[2], y1 = box[3];
+
+    struct binned_tri tri = {.clipped = weights != NULL};
+    for (int i = 0; i < 3; i++) {
+        tri.proj[i] = proj[i];
+        tri.depth[i] = depth_key(canvas, vertices[i], dist);
+        if (weights)
+            tri.weights[i] = weights[i];
+    }
+
+    uint32_t index = (uint32_t)binner->tris.count;
+    int ret = array_push(&binner->tris, &tri, sizeof(tri));
+    if (ret < 0)
+        return ret;
+
+    int64_t tx0 = (x0 + binner->offset_x) / BINNER_TILE_SIZE;
+    int64_t ty0 = (y0 + binner->offset_y) / BINNER_TILE_SIZE;
+    int64_t tx1 = (x1 + binner->offset_x) / BINNER_TILE_SIZE;
+    int64_t ty1 = (y1 + binner->offset_y) / BINNER_TILE_SIZE;
+    for (int64_t ty = ty0; ty <= ty1; ty++) {
+        for (int64_t tx = tx0; tx <= tx1; tx++) {
+            arraylist_t *bin = &binner->bins[ty * binner->tiles_x + tx];
+            ret = array_push(bin, &index, sizeof(index));
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Projects and clips a triangle like canvas_proj_tri() and queues it for the
+ * next binner_flush(). Returns the same errors canvas_proj_tri() would.
+ */
+int binner_proj_tri(binner_t *const binner, point3_t *const vertices,
+                    struct camera cam) {
+    return camera_tri(vertices, cam, &binner->canvas->cull_stats,
+                      &binner_emit_tri, binner);
+}
+
+/**
+ * Queues every face of obj like binner_proj_tri, with the vertices moved into
+ * camera space by model. Returns what canvas_draw_mesh would.
+ */
+int binner_draw_mesh(binner_t *const binner, const obj_t *const obj,
+                     const struct transform *const model, struct camera cam) {
+    canvas_t *canvas = binner->canvas;
+    return mesh_draw(&canvas->mesh_scratch, obj, model, cam,
+                     &canvas->cull_stats, &binner_emit_tri, binner);
+}
+
+/**
+ * Queues the level of lod picked by lod_select like binner_draw_mesh.
+ */
+int binner_draw_lod(binner_t *const binner, const lod_t *const lod,
+                    const struct transform *const model, struct camera cam) {
+    const obj_t *obj = &lod->levels[lod_select(lod, model, cam)];
+    return binner_draw_mesh(binner, obj, model, cam);
+}
+
+static void binner_raster_tile(void *ctx, size_t tile) {
+    binner_t *binner = (binner_t *)ctx;
+    arraylist_t *bin = &binner->bins[tile];
+    const struct binned_tri *tris = binner->tris.data;
+    const struct draw_cmd *cmds = binner->cmds.data;
+    const uint32_t *indices = bin->data;
+
+    int64_t tile_x0 = (int64_t)(tile % binner->tiles_x) * BINNER_TILE_SIZE -
+                      binner->offset_x;
+    int64_t tile_y0 = (int64_t)(tile / binner->tiles_x) * BINNER_TILE_SIZE -
+                      binner->offset_y;
+    int64_t x0 = MAX(tile_x0, 0), y0 = MAX(tile_y0, 0);
+    int64_t x1 = MIN(tile_x0 + BINNER_TILE_SIZE, binner->canvas->width) - 1;
+    int64_t y1 = MIN(tile_y0 + BINNER_TILE_SIZE, binner->canvas->height) - 1;
+
+    for (size_t i = 0; i < bin->count; i++) {
+        if (indices[i] & BIN_CMD) {
+            draw_cmd_run(binner->canvas, &cmds[indices[i] & ~BIN_CMD],
+                         (struct clip_rect){x0, y0, x1, y1});
+            continue;
+        }
+
+        const struct binned_tri *tri = &tris[indices[i]];
+        struct tri_shader shader = {
+            .mode = TRI_SHADE_RGB_DEPTH,
+            .depth = tri->depth,
+            .weights = tri->clipped ? tri->weights : NULL,
+        };
+        tri_raster_shaded(binner->canvas, tri->proj[0], tri->proj[1],
+                          tri->proj[2], x0, y0, x1, y1, &shader);
+    }
+    bin->count = 0;
+}
+
+/**
+ * Rasterizes every queued triangle and 2D draw and empties the bins.
+ */
+void binner_flush(binner_t *const binner) {
+    pool_run(&binner->pool, &binner_raster_tile, binner,
+             (size_t)binner->tiles_x * binner->tiles_y);
+    binner->tris.count = 0;
+    binner->cmds.count = 0;
+}
+
+void binner_cleanup(binner_t *const binner) {
+    if (!binner)
+        return;
+
+    pool_cleanup(&binner->pool);
+    if (binner->bins) {
+        for (size_t i = 0; i < (size_t)binner->tiles_x * binner->tiles_y; i++)
+            array_cleanup(&binner->bins[i]);
+        free(binner->bins);
+        binner->bins = NULL;
+    }
+    array_cleanup(&binner->tris);
+    array_cleanup(&binner->cmds);
+}
+
+/**
+ * Queues the 2D draw cmd in the bin of every tile its bounds touch.
+ */
+static int binner_queue_cmd(binner_t *const binner,
+                            const struct draw_cmd *const cmd) {
+    canvas_t *canvas = binner->canvas;
+    struct clip_rect box;
+    if (!draw_cmd_bounds(canvas, cmd, &box))
+        return -EDOM; // as canvas_fill_tri, beyond the guard band
+    int64_t x0 = MAX(box.x0, 0), y0 = MAX(box.y0, 0);
+    int64_t x1 = MIN(box.x1, (int64_t)canvas->width - 1);
+    int64_t y1 = MIN(box.y1, (int64_t)canvas->height - 1);
+    if (x0 > x1 || y0 > y1)
+        return 0;
+
+    uint32_t index = (uint32_t)binner->cmds.count | BIN_CMD;
+    int ret = array_push(&binner->cmds, cmd, sizeof(*cmd));
+    if (ret < 0)
+        return ret;
+    int64_t tx0 = (x0 + binner->offset_x) / BINNER_TILE_SIZE;
+    int64_t ty0 = (y0 + binner->offset_y) / BINNER_TILE_SIZE;
+    int64_t tx1 = (x1 + binner->offset_x) / BINNER_TILE_SIZE;
+    int64_t ty1 = (y1 + binner->offset_y) / BINNER_TILE_SIZE;
+    for (int64_t ty = ty0; ty <= ty1; ty++) {
+        for (int64_t tx = tx0; tx <= tx1; tx++) {
+            arraylist_t *bin = &binner->bins[ty * binner->tiles_x + tx];
+            ret = array_push(bin, &index, sizeof(index));
+            if (ret < 0)
+                return ret;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Command buffers
+ *
+ * A command buffer records draw calls with their arguments instead of
+ * running them. cmd_buffer_execute() queues them all on a binner in recording
+ * order and flushes it, so each tile replays the commands touching it on a
+ * worker thread, in the order they were recorded. The result is identical to
+ * making the same calls on the binner's canvas one after the other.
+ */
+
+int cmd_buffer_init(cmd_buffer_t *const cmds) {
+    int ret = ARRAY_MAKE(&cmds->cmds, struct draw_cmd, 64);
+    if (ret < 0)
+        return ret;
+    return ARRAY_MAKE(&cmds->text, char, 256);
+}
+
+/**
+ * Forgets every recorded command, keeping the memory for the next frame.
+ */
+void cmd_buffer_reset(cmd_buffer_t *const cmds) {
+    cmds->cmds.count = 0;
+    cmds->text.count = 0;
+}
+
+void cmd_buffer_cleanup(cmd_buffer_t *const cmds) {
+    if (!cmds)
+        return;
+    array_cleanup(&cmds->cmds);
+    array_cleanup(&cmds->text);
+}
+
+static int cmd_record(cmd_buffer_t *const cmds, struct draw_cmd cmd) {
+    if (cmds->cmds.count >= cmds->cmds.capacity) {
+        int ret = ARRAY_RESIZE(struct draw_cmd, &cmds->cmds,
+                               cmds->cmds.capacity * 2);
+        if (ret < 0)
+            return ret;
+    }
+    ((struct draw_cmd *)cmds->cmds.data)[cmds->cmds.count++] = cmd;
+    return 0;
+}
+
+int cmd_fill(cmd_buffer_t *const cmds, struct rgba color) {
+    return cmd_record(cmds, (struct draw_cmd){.type = DRAW_FILL,
+                                              .color = color});
+}
+
+int cmd_fill_rect(cmd_buffer_t *const cmds, uint32_t x, uint32_t y,
+                  uint32_t width, uint32_t height, struct rgba color) {
+    return cmd_record(cmds, (struct draw_cmd){
+                                .type = DRAW_RECT,
+                                .color = color,
+                                .rect = {x, y, width, height},
+                            });
+}
+
+int cmd_fill_circle(cmd_buffer_t *const cmds, int64_t center_x,
+                    int64_t center_y, uint32_t radius, struct rgba color) {
+    return cmd_record(cmds, (struct draw_cmd){
+                                .type = DRAW_CIRCLE,
+                                .color = color,
+                                .circle = {center_x, center_y, radius},
+                            });
+}
+
+int cmd_fill_circle_aa(cmd_buffer_t *const cmds, int64_t center_x,
+                       int64_t center_y, uint32_t radius, struct rgba color) {
+    return cmd_record(cmds, (struct draw_cmd){
+                                .type = DRAW_CIRCLE_AA,
+                                .color = color,
+                                .circle = {center_x, center_y, radius},
+                            });
+}
+
+int cmd_fill_tri(cmd_buffer_t *const cmds, int64_t x0, int64_t y0, int64_t x1,
+                 int64_t y1, int64_t x2, int64_t y2, struct rgba color) {
+    return cmd_record(cmds, (struct draw_cmd){
+                                .type = DRAW_TRI,
+                                .color = color,
+                                .tri = {{x0, y0}, {x1, y1}, {x2, y2}},
+                            });
+}
+
+/**
+ * Records canvas_fill_quad, as the same two triangles.
+ */
+int cmd_fill_quad(cmd_buffer_t *const cmds, point2_t p1, point2_t p2,
+                  point2_t p3, point2_t p4, struct rgba color) {
+    assert(p1.x < p2.x && p1.x < p3.x && p1.x < p4.x);
+    assert(p4.x > p3.x && p4.x > p2.x && p4.x > p1.x);
+
+    int ret = cmd_fill_tri(cmds, p1.x, p1.y, p2.x, p2.y, p3.x, p3.y, color);
+    if (ret < 0)
+        return ret;
+    return cmd_fill_tri(cmds, p4.x, p4.y, p2.x, p2.y, p3.x, p3.y, color);
+}
+
+int cmd_draw_line(cmd_buffer_t *const cmds, uint32_t x0, uint32_t y0,
+                  uint32_t x1, uint32_t y1, struct rgba color,
+                  uint32_t thiccness) {
+    return cmd_record(cmds, (struct draw_cmd){
+                                .type = DRAW_LINE,
+                                .color = color,
+                                .line = {x0, y0, x1, y1, thiccness},
+                            });
+}
+
+/**
+ * Records canvas_write_string. The text is copied.
+ */
+int cmd_write_string(cmd_buffer_t *const cmds, const char *str, uint32_t x,
+                     uint32_t y, font_t font, uint32_t font_size,
+                     struct rgba color) {
+    size_t len = strlen(str);
+    size_t offset = cmds->text.count;
+    if (offset + len > cmds->text.capacity) {
+        size_t capacity = MAX(cmds->text.capacity * 2, offset + len);
+        int ret = ARRAY_RESIZE(char, &cmds->text, capacity);
+        if (ret < 0)
+            return ret;
+    }
+    memcpy((char *)cmds->text.data + offset, str, len);
+    cmds->text.count += len;
+
+    return cmd_record(cmds, (struct draw_cmd){
+                                .type = DRAW_TEXT,
+                                .color = color,
+                                .text = {.offset = offset,
+                                         .len = (uint32_t)len,
+                                         .x = x,
+                                         .y = y,
+                                         .font_size = font_size,
+                                         .font = font},
+                            });
+}
+
+/**
+ * Records canvas_draw_mesh. obj is not copied, and must outlive the execution
+ * of the buffer.
+ */
+int cmd_draw_mesh(cmd_buffer_t *const cmds, const obj_t *const obj,
+                  const struct transform *const model, struct camera cam) {
+    return cmd_record(cmds, (struct draw_cmd){
+                                .type = DRAW_MESH,
+                                .mesh = {obj, *model, cam},
+                            });
+}
+
+/**
+ * Draws every recorded command into the canvas of binner, which must have
+ * nothing else queued to come after them, and flushes it. A command that
+ * fails is skipped and the rest still drawn, as with the same calls made one
+ * after the other. Returns the first error, or 0.
+ */
+int cmd_buffer_execute(const cmd_buffer_t *const cmds,
+                       binner_t *const binner) {
+    const struct draw_cmd *recorded = cmds->cmds.data;
+    int first = 0;
+    for (size_t i = 0; i < cmds->cmds.count; i++) {
+        struct draw_cmd cmd = recorded[i];
+        int ret;
+        if (cmd.type == DRAW_MESH) {
+            ret = binner_draw_mesh(binner, cmd.mesh.obj, &cmd.mesh.model,
+                                   cmd.mesh.cam);
+        } else {
+            if (cmd.type == DRAW_TEXT)
+                cmd.text.str = (const char *)cmds->text.data + cmd.text.offset;
+            ret = binner_queue_cmd(binner, &cmd);
+        }
+        if (ret < 0 && first == 0)
+            first = ret;
+    }
+    binner_flush(binner);
+    return first;
+}
+
+/**
+ * Swap chains
+ *
+ * A swap chain cycles two or three canvases between a renderer and a
+ * presenter so that drawing the next frame overlaps presenting the last one.
+ * The renderer draws into swap_chain_acquire() and hands the canvas to
+ * swap_chain_submit(). The presenter takes frames in order from
+ * swap_chain_next() and gives them back with swap_chain_release(), either on
+ * a thread of its own, such as one that owns a graphics context, or on the
+ * thread swap_chain_present_async() starts.
+ */
+
+int swap_chain_init(swap_chain_t *const chain, uint32_t width, uint32_t height,
+                    uint32_t buffer_count, enum swap_policy policy) {
+    if (buffer_count < 2 || buffer_count > SWAP_MAX_BUFFERS)
+        return -EINVAL;
+
+    *chain = (swap_chain_t){.buffer_count = buffer_count, .policy = policy};
+    for (uint32_t i = 0; i < buffer_count; i++) {
+        int ret = canvas_init(&chain->buffers[i], width, height, COLOR_BLACK);
+        if (ret < 0) {
+            while (i-- > 0)
+                canvas_cleanup(&chain->buffers[i]);
+            return ret;
+        }
+    }
+    pthread_mutex_init(&chain->lock, NULL);
+    pthread_cond_init(&chain->cv, NULL);
+    return 0;
+}
+
+/**
+ * Returns the queued buffer holding the oldest frame, or -1.
+ */
+static int swap_chain_oldest(const swap_chain_t *const chain) {
+    int oldest = -1;
+    for (uint32_t i = 0; i < chain->buffer_count; i++) {
+        if (chain->state[i] == SWAP_QUEUED &&
+            (oldest < 0 || chain->frame[i] < chain->frame[oldest]))
+            oldest = (int)i;
+    }
+    return oldest;
+}
+
+/**
+ * Returns a canvas to draw the next frame into, with its previous contents,
+ * and stores the frame's number in frame unless it is NULL. Waits for a
+ * canvas to be presented if all are in use, except under SWAP_LATEST, which
+ * takes back a queued frame instead. Returns NULL once the chain is closed.
+ */
+canvas_t *swap_chain_acquire(swap_chain_t *const chain, uint64_t *frame) {
+    pthread_mutex_lock(&chain->lock);
+    int buffer = -1;
+    while (!chain->closed) {
+        for (uint32_t i = 0; i < chain->buffer_count && buffer < 0; i++) {
+            if (chain->state[i] == SWAP_FREE)
+                buffer = (int)i;
+        }
+        if (buffer < 0 && chain->policy == SWAP_LATEST) {
+            buffer = swap_chain_oldest(chain);
+            if (buffer >= 0)
+                chain->stats.dropped++;
+        }
+        if (buffer >= 0)
+            break;
+        pthread_cond_wait(&chain->cv, &chain->lock);
+    }
+
+    canvas_t *canvas = NULL;
+    if (buffer >= 0) {
+        chain->state[buffer] = SWAP_DRAWING;
+        chain->frame[buffer] = chain->next_frame++;
+        if (frame)
+            *frame = chain->frame[buffer];
+        canvas = &chain->buffers[buffer];
+    }
+    pthread_mutex_unlock(&chain->lock);
+    return canvas;
+}
+
+/**
+ * Queues a canvas from swap_chain_acquire for presenting. Under SWAP_LATEST,
+ * any older frame still queued is dropped.
+ */
+void swap_chain_submit(swap_chain_t *const chain, canvas_t *const canvas) {
+    size_t buffer = canvas - chain->buffers;
+    canvas_resolve(canvas);
+    pthread_mutex_lock(&chain->lock);
+    if (chain->policy == SWAP_LATEST) {
+        for (uint32_t i = 0; i < chain->buffer_count; i++) {
+            if (chain->state[i] == SWAP_QUEUED) {
+                chain->state[i] = SWAP_FREE;
+                chain->stats.dropped++;
+            }
+        }
+    }
+    chain->state[buffer] = SWAP_QUEUED;
+    pthread_cond_broadcast(&chain->cv);
+    pthread_mutex_unlock(&chain->lock);
+}
+
+/**
+ * Waits for the oldest queued frame and returns its canvas, storing its number
+ * in frame unless it is NULL. Returns NULL once the chain is closed and every
+ * queued frame has been handed out.
+ */
+canvas_t *swap_chain_next(swap_chain_t *const chain, uint64_t *frame) {
+    pthread_mutex_lock(&chain->lock);
+    int buffer;
+    while ((buffer = swap_chain_oldest(chain)) < 0 && !chain->closed)
+        pthread_cond_wait(&chain->cv, &chain->lock);
+
+    canvas_t *canvas = NULL;
+    if (buffer >= 0) {
+        chain->state[buffer] = SWAP_PRESENTING;
+        if (frame)
+            *frame = chain->frame[buffer];
+        canvas = &chain->buffers[buffer];
+    }
+    pthread_mutex_unlock(&chain->lock);
+    return canvas;
+}
+
+/**
+ * Gives a canvas from swap_chain_next back to be drawn into again.
+ */
+void swap_chain_release(swap_chain_t *const chain, canvas_t *const canvas) {
+    size_t buffer = canvas - chain->buffers;
+    pthread_mutex_lock(&chain->lock);
+    chain->state[buffer] = SWAP_FREE;
+    chain->stats.presented++;
+    pthread_cond_broadcast(&chain->cv);
+    pthread_mutex_unlock(&chain->lock);
+}
+
+static void *swap_chain_present_thread(void *arg) {
+    swap_chain_t *chain = (swap_chain_t *)arg;
+    canvas_t *canvas;
+    uint64_t frame;
+    while ((canvas = swap_chain_next(chain, &frame))) {
+        chain->present(chain->present_ctx, canvas, frame);
+        swap_chain_release(chain, canvas);
+    }
+    return NULL;
+}
+
+/**
+ * Starts a thread presenting every frame swap_chain_next hands out with
+ * present, until the chain is closed and drained.
+ */
+int swap_chain_present_async(swap_chain_t *const chain, swap_present_fn present,
+                             void *ctx) {
+    if (chain->threaded)
+        return -EBUSY;
+    chain->present = present;
+    chain->present_ctx = ctx;
+    if (pthread_create(&chain->thread, NULL, &swap_chain_present_thread,
+                       chain) != 0)
+        return -EAGAIN;
+    chain->threaded = true;
+    return 0;
+}
+
+/**
+ * Stops handing out canvases to draw into. Frames already queued are still
+ * presented.
+ */
+void swap_chain_close(swap_chain_t *const chain) {
+    pthread_mutex_lock(&chain->lock);
+    chain->closed = true;
+    pthread_cond_broadcast(&chain->cv);
+    pthread_mutex_unlock(&chain->lock);
+}
+
+struct swap_stats swap_chain_stats(swap_chain_t *const chain) {
+    pthread_mutex_lock(&chain->lock);
+    struct swap_stats stats = chain->stats;
+    pthread_mutex_unlock(&chain->lock);
+    return stats;
+}
+
+/**
+ * Closes the chain, waits for the presentation thread to present what is
+ * queued, and frees the canvases.
+ */
+void swap_chain_cleanup(swap_chain_t *const chain) {
+    if (!chain || chain->buffer_count == 0)
+        return;
+
+    swap_chain_close(chain);
+    if (chain->threaded)
+        pthread_join(chain->thread, NULL);
+    chain->threaded = false;
+
+    for (uint32_t i = 0; i < chain->buffer_count; i++)
+        canvas_cleanup(&chain->buffers[i]);
+    chain->buffer_count = 0;
+    pthread_mutex_destroy(&chain->lock);
+    pthread_cond_destroy(&chain->cv);
+}
+
+/* Text */
+
+/**
+ * Returns the packed glyph of c, see struct font. Characters past the table
+ * have none.
+ */
+uint64_t font_get_glyph(font_t font, char c) {
+    if ((unsigned char)c >= 128)
+        return 0;
+    return font.glyphs[(unsigned char)c];
+}
+
+static void char_draw(canvas_t *const canvas, char c, uint32_t x, uint32_t y,
+                      font_t font, uint32_t font_size, struct rgba color,
+                      struct clip_rect clip) {
+    assert(font.glyph_width <= FONT_GLYPH_MAX &&
+           font.glyph_height <= FONT_GLYPH_MAX);
+    uint64_t glyph = font_get_glyph(font, c);
+    int64_t end_x = x + font_size * font.glyph_width - 1;
+    int64_t end_y = y + font_size * font.glyph_height - 1;
+    if (!glyph || end_x < clip.x0 || x > clip.x1 || end_y < clip.y0 ||
+        y > clip.y1)
+        return;
+
+    canvas_resolve_rect(canvas, MAX(x, clip.x0), MAX(y, clip.y0),
+                        MIN(end_x, clip.x1), MIN(end_y, clip.y1), CLEAR_COLOR,
+                        false);
+    for (uint32_t gy = 0; gy < font.glyph_height;) {
+        uint8_t row = (uint8_t)(glyph >> (gy * 8));
+
+        // Rows repeating the one above are drawn along with it
+        uint32_t rows = 1;
+        while (gy + rows < font.glyph_height &&
+               (uint8_t)(glyph >> ((gy + rows) * 8)) == row)
+            rows++;
+
+        int64_t y0 = MAX(y + gy * font_size, clip.y0);
+        int64_t y1 = MIN(y + (gy + rows) * font_size - 1, clip.y1);
+        for (uint32_t bits = row; bits && y0 <= y1;) {
+            // Blend each run of set pixels as one scaled span per row
+            uint32_t gx = __builtin_ctz(bits);
+            uint32_t run = __builtin_ctz(~(bits >> gx));
+            bits &= ~(((1u << run) - 1) << gx);
+
+            int64_t x0 = MAX(x + gx * font_size, clip.x0);
+            int64_t x1 = MIN(x + (gx + run) * font_size - 1, clip.x1);
+            for (int64_t iy = y0; iy <= y1 && x0 <= x1; iy++)
+                span_blend(&canvas->data[iy * canvas->stride + x0],
+                           x1 - x0 + 1, color);
+        }
+        gy += rows;
+    }
+}
+
+/**
+ * Draws a character at point (x, y), clipped to the canvas.
+ */
+void canvas_draw_char(canvas_t *const canvas, char c, uint32_t x, uint32_t y,
+                      font_t font, uint32_t font_size, struct rgba color) {
+    char_draw(canvas, c, x, y, font, font_size, color,
+              canvas_clip_rect(canvas));
+}
+
+/**
+ * Writes text to the canvas starting at point (x, y), clipped to the canvas.
+ */
+void canvas_write_string(canvas_t *const canvas, const char *str, uint32_t x,
+                         uint32_t y, font_t font, uint32_t font_size,
+                         struct rgba color) {
+    uint64_t advance = (uint64_t)font_size * font.glyph_width;
+    for (uint64_t ix = x; *str && ix < canvas->width; str++, ix += advance)
+        char_draw(canvas, *str, (uint32_t)ix, y, font, font_size, color,
+                  canvas_clip_rect(canvas));
+}
+
+/**
+ * Text run cache
+ *
+ * canvas_write_string_cached keeps the pixels a string covers at a font size
+ * as a mask of bytes, so drawing it again blends the color through the mask
+ * in one pass instead of walking its glyphs. The mask does not depend on the
+ * color, so runs drawn in several colors share an entry. Blending only the
+ * covered pixels leaves the rest, alpha included, as canvas_write_string
+ * would, and the result is identical.
+ */
+
+static uint64_t text_run_hash(const char *str, font_t font,
+                              uint32_t font_size) {
+    // FNV-1a over the string, then the rest of the key
+    uint64_t hash = 0xCBF29CE484222325;
+    for (; *str; str++)
+        hash = (hash ^ (uint8_t)*str) * 0x100000001B3;
+    uint64_t rest[] = {(uintptr_t)font.glyphs, font.glyph_width,
+                       font.glyph_height, font_size};
+    for (size_t i = 0; i < sizeof(rest) / sizeof(rest[0]); i++)
+        hash = (hash ^ rest[i]) * 0x100000001B3;
+    return hash;
+}
+
+static bool text_run_matches(const struct text_run *const run, uint64_t hash,
+                             const char *str, font_t font,
+                             uint32_t font_size) {
+    return run->hash == hash && run->glyphs == font.glyphs &&
+           run->glyph_width == font.glyph_width &&
+           run->glyph_height == font.glyph_height &&
+           run->font_size == font_size && strcmp(run->str, str) == 0;
+}
+
+/**
+ * Fills in the mask of run for str, allocating it with the copy of str.
+ */
+static int text_run_render(struct text_run *const run, const char *str,
+                           font_t font, uint32_t font_size) {
+    assert(font.glyph_width <= FONT_GLYPH_MAX &&
+           font.glyph_height <= FONT_GLYPH_MAX);
+    size_t len = strlen(str);
+    uint64_t width = (uint64_t)len * font_size * font.glyph_width;
+    uint64_t height = (uint64_t)font_size * font.glyph_height;
+    if (width > CANVAS_MAX_DIM || height > CANVAS_MAX_DIM)
+        return -EINVAL;
+
+    // Rows are padded so the blend may read whole blocks of lanes
+    run->width = (uint32_t)width;
+    run->height = (uint32_t)height;
+    run->stride = (run->width + SIMD_LANES - 1) / SIMD_LANES * SIMD_LANES;
+    size_t mask_bytes = (size_t)run->stride * run->height;
+    run->bytes = mask_bytes + len + 1;
+    run->coverage = heap_malloc(run->bytes);
+    if (!run->coverage)
+        return -ENOMEM;
+    run->str = (char *)run->coverage + mask_bytes;
+    memcpy(run->str, str, len + 1);
+    memset(run->coverage, 0, mask_bytes);
+
+    for (size_t i = 0; i < len; i++) {
+        uint64_t glyph = font_get_glyph(font, str[i]);
+        uint32_t x = (uint32_t)i * font_size * font.glyph_width;
+        for (uint32_t gy = 0; gy < font.glyph_height; gy++) {
+            uint8_t *row = &run->coverage[(size_t)gy * font_size * run->stride];
+            for (uint32_t bits = (uint8_t)(glyph >> (gy * 8)); bits;) {
+                uint32_t gx = __builtin_ctz(bits);
+                uint32_t span = __builtin_ctz(~(bits >> gx));
+                bits &= ~(((1u << span) - 1) << gx);
+                memset(&row[x + gx * font_size], 0xFF, span * font_size);
+            }
+            for (uint32_t sy = 1; sy < font_size; sy++)
+                memcpy(&row[(size_t)sy * run->stride], row, run->width);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Blends color over the pixels of canvas that the mask of run, placed at
+ * (x, y), covers, clipped to the canvas.
+ */
+static void text_run_blend(canvas_t *const canvas,
+                           const struct text_run *const run, uint32_t x,
+                           uint32_t y, struct rgba color) {
+    int64_t x1 = MIN((int64_t)x + run->width, (int64_t)canvas->width) - 1;
+    int64_t y1 = MIN((int64_t)y + run->height, (int64_t)canvas->height) - 1;
+    if (x > x1 || y > y1)
+        return;
+
+    canvas_resolve_rect(canvas, x, y, x1, y1, CLEAR_COLOR, false);
+    size_t n = x1 - x + 1;
+#if SIMD_LANES > 1
+    typedef uint8_t vu8 __attribute__((vector_size(SIMD_LANES)));
+    struct lanes_color c = lanes_color_init(color);
+    vu32 solid = (vu32){0} + rgba_to_hex(color);
+    const uint64_t full = UINT64_MAX >> (64 - 8 * SIMD_LANES);
+#endif
+    for (int64_t iy = y; iy <= y1; iy++) {
+        const uint8_t *mask = &run->coverage[(size_t)(iy - y) * run->stride];
+        struct rgba *px = &canvas->data[iy * canvas->stride + x];
+        size_t i = 0;
+#if SIMD_LANES > 1
+        for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+            // Blocks the text misses are skipped, and opaque text over a
+            // whole block is stored without reading it
+            uint64_t bits = 0;
+            memcpy(&bits, &mask[i], SIMD_LANES);
+            if (!bits)
+                continue;
+            if (bits == full && color.a == 0xFF) {
+                memcpy(&px[i], &solid, sizeof(solid));
+                continue;
+            }
+
+            vu8 m8;
+            memcpy(&m8, &mask[i], sizeof(m8));
+            vu32 m = __builtin_convertvector(m8, vu32) * 0x01010101;
+            vu32 dst;
+            memcpy(&dst, &px[i], sizeof(dst));
+            vu32 blend =
+                color.a == 0xFF ? solid : lanes_blend_color(&c, dst);
+            dst = (blend & m) | (dst & ~m);
+            memcpy(&px[i], &dst, sizeof(dst));
+        }
+#endif
+        for (; i < n; i++) {
+            if (mask[i])
+                px[i] = rgba_alpha_blend(color, px[i]);
+        }
+    }
+}
+
+/**
+ * Drops the least recently used runs of cache until bytes more fit in its
+ * budget.
+ */
+static void text_cache_evict(text_cache_t *const cache, size_t bytes) {
+    struct text_run *runs = cache->runs.data;
+    while (cache->runs.count > 0 && cache->bytes + bytes > cache->budget) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < cache->runs.count; i++) {
+            if (runs[i].last_used < runs[oldest].last_used)
+                oldest = i;
+        }
+        cache->bytes -= runs[oldest].bytes;
+        free(runs[oldest].coverage);
+        runs[oldest] = runs[--cache->runs.count];
+        cache->stats.evictions++;
+    }
+}
+
+/**
+ * canvas_write_string through cache. A string drawn before at the same font
+ * and size is blended from its cached mask; others are rendered into the
+ * cache first, or drawn directly if they do not fit in its budget.
+ */
+int canvas_write_string_cached(canvas_t *const canvas,
+                               text_cache_t *const cache, const char *str,
+                               uint32_t x, uint32_t y, font_t font,
+                               uint32_t font_size, struct rgba color) {
+    if (!canvas_valid(canvas))
+        return -EINVAL;
+
+    uint64_t hash = text_run_hash(str, font, font_size);
+    struct text_run *runs = cache->runs.data;
+    for (size_t i = 0; i < cache->runs.count; i++) {
+        if (text_run_matches(&runs[i], hash, str, font, font_size)) {
+            runs[i].last_used = ++cache->clock;
+            cache->stats.hits++;
+            text_run_blend(canvas, &runs[i], x, y, color);
+            return 0;
+        }
+    }
+
+    cache->stats.misses++;
+    struct text_run run = {
+        .hash = hash,
+        .glyphs = font.glyphs,
+        .glyph_width = font.glyph_width,
+        .glyph_height = font.glyph_height,
+        .font_size = font_size,
+        .last_used = ++cache->clock,
+    };
+    int ret = text_run_render(&run, str, font, font_size);
+    if (ret < 0 || run.bytes > cache->budget) {
+        free(run.coverage);
+        canvas_write_string(canvas, str, x, y, font, font_size, color);
+        return ret == -ENOMEM ? ret : 0;
+    }
+
+    text_cache_evict(cache, run.bytes);
+    if (cache->runs.count >= cache->runs.capacity) {
+        ret = ARRAY_RESIZE(struct text_run, &cache->runs,
+                           cache->runs.capacity * 2);
+        if (ret < 0) {
+            free(run.coverage);
+            return ret;
+        }
+    }
+    ((struct text_run *)cache->runs.data)[cache->runs.count++] = run;
+    cache->bytes += run.bytes;
+    text_run_blend(canvas, &run, x, y, color);
+    return 0;
+}
+
+int text_cache_init(text_cache_t *const cache, size_t budget) {
+    *cache = (text_cache_t){.budget = budget};
+    return ARRAY_MAKE(&cache->runs, struct text_run, 16);
+}
+
+/**
+ * Returns how often runs were found in cache, rendered, and dropped for
+ * space.
+ */
+struct text_cache_stats text_cache_stats(const text_cache_t *const cache) {
+    return cache->stats;
+}
+
+void text_cache_cleanup(text_cache_t *const cache) {
+    if (!cache)
+        return;
+    struct text_run *runs = cache->runs.data;
+    for (size_t i = 0; i < cache->runs.count; i++)
+        free(runs[i].coverage);
+    array_cleanup(&cache->runs);
+    cache->bytes = 0;
+}
+
+/**
+ * Renders a canvas to a file in PPM P6 format.
+ */
+void canvas_render_ppm(const canvas_t *const canvas, const char *filename) {
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        perror("Could not open file");
+        return;
+    }
+
+    fprintf(file, "P6\n%u %u 255\n", canvas->width, canvas->height);
+    struct rgba buf[HIZ_TILE_SIZE];
+    for (uint32_t y = 0; y < canvas->height; y++) {
+        uint32_t n;
+        for (uint32_t x = 0; x < canvas->width; x += n) {
+            const struct rgba *row =
+                canvas_shown_span(canvas, x, y, canvas->width, buf, &n);
+            for (uint32_t i = 0; i < n; i++) {
+                struct rgba color = row[i];
+                fwrite(&color.r, sizeof(uint8_t), 1, file);
+                fwrite(&color.g, sizeof(uint8_t), 1, file);
+                fwrite(&color.b, sizeof(uint8_t), 1, file);
+            }
+        }
+    }
+    fclose(file);
+}
+
+/**
+ * Streams the dirty tiles of canvas to file, merged as by canvas_dirty_rects,
+ * as a sequence of PPM P6 images. A comment line after the magic number of
+ * each holds its position in the canvas, "# x y". rects is scratch space for
+ * the rectangles, kept to be reused. Returns the number of images written,
+ * -ENOMEM if the rectangles did not fit in rects, or -EIO.
+ */
+int canvas_write_dirty_ppm(const canvas_t *const canvas, FILE *file,
+                           arraylist_t *const rects) {
+    int count = canvas_dirty_rects(canvas, rects);
+    if (count < 0)
+        return count;
+    const struct dirty_rect *r = rects->data;
+    struct rgba buf[HIZ_TILE_SIZE];
+    for (int i = 0; i < count; i++) {
+        fprintf(file, "P6\n# %u %u\n%u %u 255\n", r[i].x, r[i].y, r[i].width,
+                r[i].height);
+        uint32_t x_end = r[i].x + r[i].width;
+        for (uint32_t y = r[i].y; y < r[i].y + r[i].height; y++) {
+            uint32_t n;
+            for (uint32_t x = r[i].x; x < x_end; x += n) {
+                const struct rgba *row =
+                    canvas_shown_span(canvas, x, y, x_end, buf, &n);
+                for (uint32_t j = 0; j < n; j++)
+                    fwrite(&row[j], sizeof(uint8_t), 3, file);
+            }
+        }
+    }
+    return ferror(file) ? -EIO : count;
+}
+
+/**
+ * Loads a canvas from PPM P6 file.
+ */
+canvas_t canvas_load_ppm(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        perror("Could not load canvas");
+        exit(1);
+    }
+
+    char *token = NULL;
+
+    // Parse format
+    char line[32];
+    if (!fgets(line, sizeof(line), file)) {
+        perror("Could not read format from file");
+        exit(1);
+    }
+    printf("LOADING CANVAS FROM FILE %s, FORMAT=%s", filename, line);
+
+    token = strtok(line, "\n");
+    if (strcmp(token, "P6") != 0) {
+        perror("MLCanvasLoadPPM currently only supports P6 format\n");
+        exit(1);
+    }
+
+    // Parse size and (ignored for now) color depth
+    uint32_t width;
+    uint32_t height;
+    uint16_t bit_depth;
+
+    if (!fgets(line, sizeof(line), file)) {
+        perror("Could not read size/color depth from file");
+        exit(1);
+    }
+
+    token = strtok(line, " ");
+    width = atoi(token);
+    token = strtok(NULL, " ");
+    height = atoi(token);
+    token = strtok(NULL, " ");
+    bit_depth = atoi(token);
+    printf("CANVAS WIDTH=%u, HEIGHT=%u, BIT_DEPTH=%u\n", width, height,
+           bit_depth);
+
+    // Interpret bytes as colors (struct rgba)
+    canvas_t canvas;
+    if (canvas_init(&canvas, width, height, COLOR_BLACK) < 0) {
+        perror("Could not allocate data\n");
+        exit(1);
+    }
+    // Each row is read into the back of its own pixels and widened front to
+    // back: pixel x is written to bytes [4x, 4x + 4) after reading bytes
+    // [width + 3x, width + 3x + 3), which never overlaps a later pixel
+    for (uint32_t y = 0; y < height; y++) {
+        struct rgba *row = &canvas.data[(size_t)y * canvas.stride];
+        uint8_t *raw = (uint8_t *)row + width;
+        size_t bytes_read = fread(raw, 1, 3 * (size_t)width, file);
+        if (bytes_read != 3 * (size_t)width) {
+            perror("Could not read enough bytes\n");
+            printf("Bytes read %zu\n", (size_t)y * 3 * width + bytes_read);
+            exit(1);
+        }
+        for (uint32_t x = 0; x < width; x++) {
+            row[x] = (struct rgba){raw[x * 3 + 0], raw[x * 3 + 1],
+                                   raw[x * 3 + 2], 0xFF};
+        }
+    }
+
+    fclose(file);
+
+    return canvas;
+}
+
+/**
+ * Reallocates an OBJ_ALIGN aligned array of count items to capacity items.
+ * The old array is freed on success.
+ */
+static void *obj_realloc(void *old, size_t count, size_t capacity,
+                         size_t item_size) {
+    size_t bytes = capacity * item_size;
+    bytes = (bytes + OBJ_ALIGN - 1) / OBJ_ALIGN * OBJ_ALIGN;
+    void *data = heap_aligned_alloc(OBJ_ALIGN, bytes);
+    if (!data)
+        return NULL;
+    if (old) {
+        memcpy(data, old, count * item_size);
+        free(old);
+    }
+    return data;
+}
+
+static int obj_reserve_vertices(obj_t *const obj, size_t capacity) {
+    // Keep whole OBJ_ALIGN blocks of floats
+    size_t block = OBJ_ALIGN / sizeof(float);
+    capacity = (capacity + block - 1) / block * block;
+
+    float **coords[3] = {&obj->x, &obj->y, &obj->z};
+    for (int i = 0; i < 3; i++) {
+        float *data = obj_realloc(*coords[i], obj->vertex_count, capacity,
+                                  sizeof(float));
+        if (!data)
+            return -ENOMEM;
+        *coords[i] = data;
+    }
+    obj->vertex_capacity = capacity;
+    return 0;
+}
+
+static int obj_reserve_faces(obj_t *const obj, size_t capacity) {
+    uint32_t *data = obj_realloc(obj->indices, obj->face_count * 3,
+                                 capacity * 3, sizeof(uint32_t));
+    if (!data)
+        return -ENOMEM;
+    obj->indices = data;
+    obj->face_capacity = capacity;
+    return 0;
+}
+
+static void obj_extend_bounds(obj_t *const obj, point3_t lo, point3_t hi) {
+    obj->bounds_min.x = MIN(obj->bounds_min.x, lo.x);
+    obj->bounds_min.y = MIN(obj->bounds_min.y, lo.y);
+    obj->bounds_min.z = MIN(obj->bounds_min.z, lo.z);
+    obj->bounds_max.x = MAX(obj->bounds_max.x, hi.x);
+    obj->bounds_max.y = MAX(obj->bounds_max.y, hi.y);
+    obj->bounds_max.z = MAX(obj->bounds_max.z, hi.z);
+}
+
+int obj_init(obj_t *const obj) {
+    int ret;
+    *obj = (obj_t){
+        .bounds_min = {FLT_MAX, FLT_MAX, FLT_MAX},
+        .bounds_max = {-FLT_MAX, -FLT_MAX, -FLT_MAX},
+    };
+    ret = obj_reserve_vertices(obj, 256);
+    if (ret == 0)
+        ret = obj_reserve_faces(obj, 512);
+    if (ret < 0)
+        obj_cleanup(obj);
+    return ret;
+}
+
+/**
+ * OBJ parsing
+ *
+ * obj_load maps the file and splits it into chunks of whole lines, which the
+ * worker pool parses into one obj_t each. The chunks are then appended to the
+ * result in file order. Only `v` and `f` statements are read; comments,
+ * blank lines and other statements are skipped.
+ */
+
+#define OBJ_CHUNK_MIN_BYTES (1 << 20) // Smaller files are parsed by the caller
+
+struct obj_chunk {
+    const char *start;
+    const char *end;
+    obj_t obj;
+    size_t skipped; // Unsupported statements
+    int ret;
+};
+
+static const double obj_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static inline bool obj_is_space(char c) { return c == ' ' || c == '\t'; }
+
+static inline bool obj_is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static inline const char *obj_skip_space(const char *p, const char *end) {
+    while (p < end && obj_is_space(*p))
+        p++;
+    return p;
+}
+
+static inline const char *obj_skip_line(const char *p, const char *end) {
+    const char *eol = memchr(p, '\n', end - p);
+    return eol ? eol + 1 : end;
+}
+
+/**
+ * Parses a decimal float ([sign] digits [. digits] [e [sign] digits]) at p,
+ * independent of the locale. Returns the first byte after it, or NULL if there
+ * is no number at p.
+ */
+static const char *obj_parse_float(const char *p, const char *end,
+                                   float *out) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    // Up to 19 significant digits fit the mantissa, the rest only scale it
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false;
+    for (; p < end && obj_is_digit(*p); p++, any = true) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            digits += mantissa > 0;
+        } else {
+            exponent++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && obj_is_digit(*p); p++, any = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                digits += mantissa > 0;
+                exponent--;
+            }
+        }
+    }
+    if (!any)
+        return NULL;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool exp_negative = false;
+        if (q < end && (*q == '-' || *q == '+'))
+            exp_negative = *q++ == '-';
+        if (q < end && obj_is_digit(*q)) {
+            int e = 0;
+            for (; q < end && obj_is_digit(*q); q++)
+                e = MIN(e * 10 + (*q - '0'), 100000);
+            exponent += exp_negative ? -e : e;
+            p = q;
+        }
+    }
+
+    // Zero stays zero whatever the exponent, where pow() could give 0 * inf =
+    // NaN. With at most 19 digits, exponents beyond these round to 0 or
+    // overflow the float.
+    double value = (double)mantissa;
+    if (mantissa == 0 || exponent < -65)
+        value = 0;
+    else if (exponent > 38)
+        value = INFINITY;
+    else if (exponent < 0 && exponent >= -22)
+        value /= obj_pow10[-exponent];
+    else if (exponent > 0 && exponent <= 22)
+        value *= obj_pow10[exponent];
+    else if (exponent != 0)
+        value *= pow(10, exponent);
+
+    *out = (float)(negative ? -value : value);
+    return p;
+}
+
+/**
+ * Parses a face vertex (v, v/vt, v//vn or v/vt/vn), keeping the 1-based
+ * position index.
+ */
+static const char *obj_parse_index(const char *p, const char *end,
+                                   size_t *out) {
+    if (p >= end || !obj_is_digit(*p))
+        return NULL; // Relative (negative) indices are not supported
+
+    size_t index = 0;
+    for (; p < end && obj_is_digit(*p); p++) {
+        index = index * 10 + (size_t)(*p - '0');
+        if (index > UINT32_MAX)
+            return NULL;
+    }
+    while (p < end && (*p == '/' || obj_is_digit(*p)))
+        p++;
+    *out = index;
+    return p;
+}
+
+static int obj_parse_vertex(obj_t *const obj, const char *p,
+                            const char *end) {
+    float xyz[3];
+    for (int i = 0; i < 3; i++) {
+        p = obj_skip_space(p, end);
+        p = obj_parse_float(p, end, &xyz[i]);
+        if (!p)
+            return -EINVAL;
+    }
+    return obj_add_vertex(obj, xyz[0], xyz[1], xyz[2]);
+}
+
+/**
+ * Parses a face, splitting polygons into a fan of triangles.
+ */
+static int obj_parse_face(obj_t *const obj, const char *p, const char *end) {
+    size_t first = 0, prev = 0;
+    int count = 0;
+    for (;;) {
+        p = obj_skip_space(p, end);
+        if (p >= end || *p == '\n' || *p == '\r' || *p == '#')
+            break;
+
+        size_t index;
+        p = obj_parse_index(p, end, &index);
+        if (!p)
+            return -EINVAL;
+
+        if (count == 0) {
+            first = index;
+        } else if (count >= 2) {
+            int ret = obj_add_face(obj, first, prev, index);
+            if (ret < 0)
+                return ret;
+        }
+        prev = index;
+        count++;
+    }
+    return count >= 3 ? 0 : -EINVAL;
+}
+
+static void obj_parse_chunk(void *ctx, size_t index) {
+    struct obj_chunk *chunk = &((struct obj_chunk *)ctx)[index];
+    const char *p = chunk->start;
+    const char *end = chunk->end;
+
+    chunk->ret = obj_init(&chunk->obj);
+    while (p < end && chunk->ret == 0) {
+        const char *line = obj_skip_space(p, end);
+        const char *eol = obj_skip_line(line, end);
+
+        if (line + 1 < eol && obj_is_space(line[1]) && line[0] == 'v') {
+            chunk->ret = obj_parse_vertex(&chunk->obj, line + 2, eol);
+        } else if (line + 1 < eol && obj_is_space(line[1]) &&
+                   line[0] == 'f') {
+            chunk->ret = obj_parse_face(&chunk->obj, line + 2, eol);
+        } else if (line < eol && *line != '#' && *line != '\n' &&
+                   *line != '\r') {
+            chunk->skipped++;
+        }
+        p = eol;
+    }
+}
+
+/**
+ * Appends the vertices and faces of src to obj.
+ */
+static int obj_append(obj_t *const obj, const obj_t *const src) {
+    int ret;
+    size_t vertices = obj->vertex_count + src->vertex_count;
+    if (vertices > obj->vertex_capacity) {
+        ret = obj_reserve_vertices(obj, vertices);
+        if (ret < 0)
+            return ret;
+    }
+    size_t faces = obj->face_count + src->face_count;
+    if (faces > obj->face_capacity) {
+        ret = obj_reserve_faces(obj, faces);
+        if (ret < 0)
+            return ret;
+    }
+
+    size_t n = src->vertex_count;
+    memcpy(&obj->x[obj->vertex_count], src->x, n * sizeof(float));
+    memcpy(&obj->y[obj->vertex_count], src->y, n * sizeof(float));
+    memcpy(&obj->z[obj->vertex_count], src->z, n * sizeof(float));
+    memcpy(&obj->indices[obj->face_count * 3], src->indices,
+           src->face_count * 3 * sizeof(uint32_t));
+    obj->vertex_count = vertices;
+    obj->face_count = faces;
+    obj_extend_bounds(obj, src->bounds_min, src->bounds_max);
+    return 0;
+}
+
+/**
+ * Splits the text into chunk_count chunks of whole lines, parses them in
+ * parallel and merges the results into obj in order.
+ */
+static int obj_parse(obj_t *const obj, const char *text, size_t size,
+                     size_t chunk_count, size_t *skipped) {
+    struct obj_chunk *chunks = heap_calloc(chunk_count, sizeof(*chunks));
+    if (!chunks)
+        return -ENOMEM;
+
+    const char *end = text + size;
+    const char *start = text;
+    for (size_t i = 0; i < chunk_count; i++) {
+        const char *split = text + size / chunk_count * (i + 1);
+        chunks[i].start = start;
+        chunks[i].end =
+            i + 1 == chunk_count ? end : obj_skip_line(MAX(split, start), end);
+        start = chunks[i].end;
+    }
+
+    if (chunk_count == 1) {
+        obj_parse_chunk(chunks, 0);
+    } else {
+        pool_t pool;
+        int ret = pool_init(&pool, (uint32_t)chunk_count);
+        if (ret < 0) {
+            free(chunks);
+            return ret;
+        }
+        pool_run(&pool, &obj_parse_chunk, chunks, chunk_count);
+        pool_cleanup(&pool);
+    }
+
+    int ret = obj_init(obj);
+    *skipped = 0;
+    for (size_t i = 0; i < chunk_count; i++) {
+        if (ret == 0)
+            ret = chunks[i].ret;
+        if (ret == 0)
+            ret = obj_append(obj, &chunks[i].obj);
+        *skipped += chunks[i].skipped;
+        obj_cleanup(&chunks[i].obj);
+    }
+    free(chunks);
+
+    // Faces may only refer to vertices of the file
+    for (size_t i = 0; ret == 0 && i < obj->face_count * 3; i++) {
+        if (obj->indices[i] >= obj->vertex_count)
+            ret = -EINVAL;
+    }
+
+    if (ret < 0)
+        obj_cleanup(obj);
+    return ret;
+}
+
+int obj_load(obj_t *const obj, const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        int ret = -errno;
+        fprintf(stderr, "Could not open %s: %s\n", filename, strerror(errno));
+        return ret;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        int ret = -errno;
+        close(fd);
+        return ret;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return obj_init(obj);
+    }
+
+    const char *text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED)
+        return -errno;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t chunk_count = MAX(size / OBJ_CHUNK_MIN_BYTES, 1);
+    chunk_count = MIN(chunk_count, cpus > 0 ? (size_t)cpus : 1);
+
+    size_t skipped;
+    int ret = obj_parse(obj, text, size, chunk_count, &skipped);
+    munmap((void *)text, size);
+
+    if (ret < 0)
+        fprintf(stderr, "ERROR: Could not parse %s\n", filename);
+    else if (skipped > 0)
+        fprintf(stderr, "WARNING: Skipped %zu unsupported lines in %s\n",
+                skipped, filename);
+    return ret;
+}
+
+inline size_t obj_vertex_count(const obj_t *const obj) {
+    return obj->vertex_count;
+}
+
+inline size_t obj_face_count(const obj_t *const obj) {
+    return obj->face_count;
+}
+
+int obj_add_vertex(obj_t *const obj, float x, float y, float z) {
+    if (obj->mapping)
+        return -EROFS;
+    if (obj->vertex_count >= obj->vertex_capacity) {
+        // At least one block, as a zeroed obj_t has no capacity to double
+        int ret = obj_reserve_vertices(
+            obj, MAX(obj->vertex_capacity * 2, OBJ_ALIGN / sizeof(float)));
+        if (ret < 0)
+            return ret;
+    }
+
+    size_t i = obj->vertex_count++;
+    obj->x[i] = x;
+    obj->y[i] = y;
+    obj->z[i] = z;
+
+    point3_t p = {x, y, z};
+    if (i == 0)
+        obj->bounds_min = obj->bounds_max = p;
+    obj_extend_bounds(obj, p, p);
+    return 0;
+}
+
+int obj_add_face(obj_t *const obj, size_t i, size_t j, size_t k) {
+    if (obj->mapping)
+        return -EROFS;
+
+    // obj_t stores vertex indices 1-indexed, we'll correct that here
+    if (i == 0 || j == 0 || k == 0 || i > UINT32_MAX || j > UINT32_MAX ||
+        k > UINT32_MAX)
+        return -EINVAL;
+
+    if (obj->face_count >= obj->face_capacity) {
+        int ret = obj_reserve_faces(
+            obj, MAX(obj->face_capacity * 2, OBJ_ALIGN / sizeof(uint32_t)));
+        if (ret < 0)
+            return ret;
+    }
+
+    uint32_t *face = &obj->indices[obj->face_count++ * 3];
+    face[0] = (uint32_t)(i - 1);
+    face[1] = (uint32_t)(j - 1);
+    face[2] = (uint32_t)(k - 1);
+    return 0;
+}
+
+point3_t obj_get_vertex(const obj_t *const obj, size_t i, float scale) {
+    if (i >= obj->vertex_count) {
+        fprintf(stderr, "ERROR: Vertex %zu out of bounds, count: %zu\n", i,
+                obj->vertex_count);
+        exit(1);
+    }
+    return (point3_t){obj->x[i] * scale, obj->y[i] * scale,
+                      obj->z[i] * scale};
+}
+
+struct vec3z obj_get_face(const obj_t *const obj, size_t i) {
+    if (i >= obj->face_count) {
+        fprintf(stderr, "ERROR: Face %zu out of bounds, count: %zu\n", i,
+                obj->face_count);
+        exit(1);
+    }
+    const uint32_t *face = obj_face(obj, i);
+    return (struct vec3z){face[0], face[1], face[2]};
+}
+
+void obj_cleanup(obj_t *obj) {
+    if (obj->mapping) {
+        munmap(obj->mapping, obj->mapping_size);
+    } else {
+        free(obj->x);
+        free(obj->y);
+        free(obj->z);
+        free(obj->indices);
+    }
+    *obj = (obj_t){0};
+}
+
+/**
+ * Mesh optimization
+ *
+ * obj_optimize reorders the faces so that consecutive faces share vertices,
+ * using Tom Forsyth's linear-speed vertex cache optimization: faces are
+ * emitted greedily by a score favouring vertices recently used and vertices
+ * with few faces left. The vertices are then renumbered in the order the
+ * faces first use them, so both the transform pass and the face gather of
+ * mesh_draw walk memory mostly forwards. Each face keeps its own vertex
+ * order, which keeps its winding and its interpolated colors.
+ */
+
+#define OPT_CACHE_SIZE 32
+#define OPT_CACHE_DECAY_POWER 1.5f
+#define OPT_LAST_TRI_SCORE 0.75f
+#define OPT_VALENCE_BOOST_SCALE 2.0f
+#define OPT_VALENCE_BOOST_POWER 0.5f
+
+struct opt_vertex {
+    float score;
+    int32_t cache_pos;  // -1 when not in the cache
+    uint32_t remaining; // Faces not yet emitted
+    uint32_t first;     // Start of this vertex' faces in opt.faces
+};
+
+static float opt_vertex_score(const struct opt_vertex *const v) {
+    if (v->remaining == 0)
+        return -1.0f;
+
+    float score = 0;
+    if (v->cache_pos >= 0) {
+        if (v->cache_pos < 3) {
+            // The last face's vertices, deliberately not the best, so the
+            // next face does not just alternate around one vertex
+            score = OPT_LAST_TRI_SCORE;
+        } else {
+            float scale = 1.0f / (OPT_CACHE_SIZE - 3);
+            score = powf(1.0f - (float)(v->cache_pos - 3) * scale,
+                         OPT_CACHE_DECAY_POWER);
+        }
+    }
+    return score + OPT_VALENCE_BOOST_SCALE *
+                       powf((float)v->remaining, -OPT_VALENCE_BOOST_POWER);
+}
+
+/**
+ * Writes the order in which to emit the faces of obj to order.
+ */
+static int opt_face_order(const obj_t *const obj, uint32_t *order) {
+    size_t vertex_count = obj->vertex_count;
+    size_t face_count = obj->face_count;
+    struct opt_vertex *vertices = heap_calloc(vertex_count, sizeof(*vertices));
+    uint32_t *adjacency = heap_malloc(face_count * 3 * sizeof(uint32_t));
+    float *face_score = heap_malloc(face_count * sizeof(float));
+    bool *emitted = heap_calloc(face_count, sizeof(bool));
+    if (!vertices || !adjacency || !face_score || !emitted) {
+        free(vertices);
+        free(adjacency);
+        free(face_score);
+        free(emitted);
+        return -ENOMEM;
+    }
+
+    // Faces of each vertex, as one array partitioned by vertex
+    const uint32_t *indices = obj->indices;
+    for (size_t i = 0; i < face_count * 3; i++)
+        vertices[indices[i]].remaining++;
+    uint32_t offset = 0;
+    for (size_t i = 0; i < vertex_count; i++) {
+        vertices[i].first = offset;
+        offset += vertices[i].remaining;
+        vertices[i].remaining = 0;
+        vertices[i].cache_pos = -1;
+    }
+    for (size_t i = 0; i < face_count * 3; i++) {
+        struct opt_vertex *v = &vertices[indices[i]];
+        adjacency[v->first + v->remaining++] = (uint32_t)(i / 3);
+    }
+
+    for (size_t i = 0; i < vertex_count; i++)
+        vertices[i].score = opt_vertex_score(&vertices[i]);
+    for (size_t i = 0; i < face_count; i++) {
+        face_score[i] = vertices[indices[i * 3]].score +
+                        vertices[indices[i * 3 + 1]].score +
+                        vertices[indices[i * 3 + 2]].score;
+    }
+
+    // The cache has room for one face past its size while it is updated
+    uint32_t cache[OPT_CACHE_SIZE + 3];
+    int cache_count = 0;
+    size_t scan = 0; // Faces before this have all been emitted
+    int64_t best = -1;
+    for (size_t n = 0; n < face_count; n++) {
+        if (best < 0) {
+            // Nothing in the cache has faces left: take the best of the rest
+            float best_score = -FLT_MAX;
+            while (emitted[scan])
+                scan++;
+            for (size_t i = scan; i < face_count; i++) {
+                if (!emitted[i] && face_score[i] > best_score) {
+                    best_score = face_score[i];
+                    best = (int64_t)i;
+                }
+            }
+        }
+
+        uint32_t face = (uint32_t)best;
+        order[n] = face;
+        emitted[face] = true;
+
+        // Move the face's vertices to the front of the cache
+        uint32_t next[OPT_CACHE_SIZE + 3];
+        int next_count = 0;
+        for (int j = 0; j < 3; j++) {
+            uint32_t index = indices[face * 3 + j];
+            next[next_count++] = index;
+
+            struct opt_vertex *v = &vertices[index];
+            uint32_t *faces = &adjacency[v->first];
+            for (uint32_t k = 0; k < v->remaining; k++) {
+                if (faces[k] == face) {
+                    faces[k] = faces[--v->remaining];
+                    break;
+                }
+            }
+        }
+        for (int j = 0; j < cache_count; j++) {
+            uint32_t index = cache[j];
+            if (index != next[0] && index != next[1] && index != next[2])
+                next[next_count++] = index;
+        }
+
+        // Rescore what was in the cache, including the vertices pushed out
+        for (int j = 0; j < next_count; j++) {
+            struct opt_vertex *v = &vertices[next[j]];
+            v->cache_pos = j < OPT_CACHE_SIZE ? j : -1;
+            v->score = opt_vertex_score(v);
+        }
+
+        best = -1;
+        float best_score = -FLT_MAX;
+        for (int j = 0; j < next_count; j++) {
+            const struct opt_vertex *v = &vertices[next[j]];
+            const uint32_t *faces = &adjacency[v->first];
+            for (uint32_t k = 0; k < v->remaining; k++) {
+                uint32_t f = faces[k];
+                face_score[f] = vertices[indices[f * 3]].score +
+                                vertices[indices[f * 3 + 1]].score +
+                                vertices[indices[f * 3 + 2]].score;
+                if (face_score[f] > best_score) {
+                    best_score = face_score[f];
+                    best = f;
+                }
+            }
+        }
+
+        cache_count = MIN(next_count, OPT_CACHE_SIZE);
+        memcpy(cache, next, cache_count * sizeof(uint32_t));
+    }
+
+    free(vertices);
+    free(adjacency);
+    free(face_score);
+    free(emitted);
+    return 0;
+}
+
+/**
+ * Reorders the faces of obj for vertex cache reuse and renumbers its vertices
+ * in first-use order. Vertices no face uses are moved to the end. Returns
+ * -EROFS for a mapped mesh cache.
+ */
+int obj_optimize(obj_t *const obj) {
+    if (obj->mapping)
+        return -EROFS;
+    if (obj->face_count == 0)
+        return 0;
+
+    size_t vertex_count = obj->vertex_count;
+    size_t face_count = obj->face_count;
+    uint32_t *order = heap_malloc(face_count * sizeof(uint32_t));
+    uint32_t *remap = heap_malloc(vertex_count * sizeof(uint32_t));
+    uint32_t *indices = heap_malloc(face_count * 3 * sizeof(uint32_t));
+    float *coords = heap_malloc(vertex_count * sizeof(float));
+    int ret = order && remap && indices && coords ? 0 : -ENOMEM;
+    if (ret == 0)
+        ret = opt_face_order(obj, order);
+    if (ret < 0) {
+        free(order);
+        free(remap);
+        free(indices);
+        free(coords);
+        return ret;
+    }
+
+    for (size_t i = 0; i < vertex_count; i++)
+        remap[i] = UINT32_MAX;
+    uint32_t next = 0;
+    for (size_t i = 0; i < face_count; i++) {
+        const uint32_t *face = &obj->indices[order[i] * 3];
+        for (int j = 0; j < 3; j++) {
+            if (remap[face[j]] == UINT32_MAX)
+                remap[face[j]] = next++;
+            indices[i * 3 + j] = remap[face[j]];
+        }
+    }
+    for (size_t i = 0; i < vertex_count; i++) {
+        if (remap[i] == UINT32_MAX)
+            remap[i] = next++;
+    }
+    memcpy(obj->indices, indices, face_count * 3 * sizeof(uint32_t));
+
+    float *axes[3] = {obj->x, obj->y, obj->z};
+    for (int axis = 0; axis < 3; axis++) {
+        for (size_t i = 0; i < vertex_count; i++)
+            coords[remap[i]] = axes[axis][i];
+        memcpy(axes[axis], coords, vertex_count * sizeof(float));
+    }
+
+    free(order);
+    free(remap);
+    free(indices);
+    free(coords);
+    return 0;
+}
+
+/**
+ * The average cache miss ratio of obj: vertices transformed per face when
+ * the faces are drawn in order through a FIFO cache of cache_size vertices.
+ * 3 is no reuse at all, and about 0.5 is the best a closed mesh can reach.
+ */
+float obj_acmr(const obj_t *const obj, uint32_t cache_size) {
+    if (obj->face_count == 0)
+        return 0;
+
+    // A vertex is cached if fewer than cache_size misses happened since its
+    // own
+    uint64_t *stamp = heap_malloc(obj->vertex_count * sizeof(uint64_t));
+    if (!stamp)
+        return -1;
+    for (size_t i = 0; i < obj->vertex_count; i++)
+        stamp[i] = UINT64_MAX;
+
+    uint64_t misses = 0;
+    for (size_t i = 0; i < obj->face_count * 3; i++) {
+        uint32_t index = obj->indices[i];
+        if (stamp[index] == UINT64_MAX || misses - stamp[index] >= cache_size)
+            stamp[index] = misses++;
+    }
+
+    free(stamp);
+    return (float)misses / (float)obj->face_count;
+}
+
+/**
+ * Mesh simplification
+ *
+ * obj_simplify reduces a mesh with quadric error edge collapses (Garland and
+ * Heckbert). Every vertex carries the sum of the squared distances to the
+ * planes of its faces as a quadric, and an edge collapses to the point that
+ * minimizes the summed quadrics of its ends. Rather than keeping a priority
+ * queue, passes over the faces collapse every edge below an error threshold
+ * that grows each pass, until enough faces are gone. Vertices at the same
+ * position are welded first, so that seams in the source do not open up.
+ * Collapses that would flip a face are skipped, and surviving faces keep
+ * their vertex order, so the winding stays as it was.
+ *
+ * The structure of the passes follows Sven Forstmann's Fast Quadric Mesh
+ * Simplification: quadrics stored as the upper triangle of a symmetric
+ * matrix, the threshold schedule 1e-9 * (pass + 3)^aggressiveness, deleted
+ * and dirty flags on the faces, and rebuilding the vertex-to-face references
+ * every few passes. It is used under the MIT license:
+ *
+ *   https://github.com/sp4cerat/Fast-Quadric-Mesh-Simplification
+ *
+ *   Copyright (c) 2014 Sven Forstmann
+ *
+ *   Permission is hereby granted, free of charge, to any person obtaining a
+ *   copy of this software and associated documentation files (the
+ *   "Software"), to deal in the Software without restriction, including
+ *   without limitation the rights to use, copy, modify, merge, publish,
+ *   distribute, sublicense, and/or sell copies of the Software, and to
+ *   permit persons to whom the Software is furnished to do so, subject to
+ *   the following conditions:
+ *
+ *   The above copyright notice and this permission notice shall be included
+ *   in all copies or substantial portions of the Software.
+ *
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ *   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ *   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ *   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ *   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#define SIMPLIFY_MAX_PASSES 100
+#define SIMPLIFY_AGGRESSIVENESS 7.0 // How fast the error threshold grows
+#define SIMPLIFY_REBUILD_PASSES 5   // Passes between compacting the faces
+
+struct simp_vertex {
+    double p[3];
+    double q[10]; // Symmetric 4x4 quadric, upper triangle by rows
+    uint32_t tstart; // This vertex' faces in simplify.refs
+    uint32_t tcount;
+    bool border;
+};
+
+struct simp_tri {
+    uint32_t v[3];
+    double err[4]; // Collapse error of each edge, and the least of them
+    double n[3];
+    bool deleted;
+    bool dirty; // Changed in this pass
+};
+
+struct simp_ref {
+    uint32_t tri;
+    uint32_t corner; // Which of tri's vertices this is
+};
+
+struct simplify {
+    struct simp_vertex *vertices;
+    size_t vertex_count;
+    arraylist_t tris;
+    arraylist_t refs;
+    bool *collapsed[2]; // Per face of each end: whether the collapse drops it
+    size_t collapsed_capacity;
+};
+
+static void quadric_plane(double q[10], double a, double b, double c,
+                          double d) {
+    q[0] = a * a, q[1] = a * b, q[2] = a * c, q[3] = a * d;
+    q[4] = b * b, q[5] = b * c, q[6] = b * d;
+    q[7] = c * c, q[8] = c * d;
+    q[9] = d * d;
+}
+
+static double quadric_error(const double q[10], const double p[3]) {
+    double x = p[0], y = p[1], z = p[2];
+    return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x +
+           q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y + q[7] * z * z +
+           2 * q[8] * z + q[9];
+}
+
+static double det3(double a, double b, double c, double d, double e, double f,
+                   double g, double h, double i) {
+    return a * (e * i - f * h) - b * (d * i - f * g) + c * (d * h - e * g);
+}
+
+static void vec3d_sub(const double a[3], const double b[3], double out[3]) {
+    for (int i = 0; i < 3; i++)
+        out[i] = a[i] - b[i];
+}
+
+static double vec3d_dot(const double a[3], const double b[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static void vec3d_cross(const double a[3], const double b[3], double out[3]) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static void vec3d_normalize(double v[3]) {
+    double len = sqrt(vec3d_dot(v, v));
+    if (len > 0) {
+        for (int i = 0; i < 3; i++)
+            v[i] /= len;
+    }
+}
+
+/**
+ * The error of collapsing the edge (i0, i1), and the point it collapses to.
+ */
+static double simplify_edge_error(const struct simplify *const s, uint32_t i0,
+                                  uint32_t i1, double p[3]) {
+    const struct simp_vertex *v0 = &s->vertices[i0];
+    const struct simp_vertex *v1 = &s->vertices[i1];
+    double q[10];
+    for (int i = 0; i < 10; i++)
+        q[i] = v0->q[i] + v1->q[i];
+
+    // The quadric's minimum, unless it is not unique or the edge is on the
+    // border, which should not move
+    double det = det3(q[0], q[1], q[2], q[1], q[4], q[5], q[2], q[5], q[7]);
+    if (det != 0 && !(v0->border && v1->border)) {
+        p[0] = -det3(q[3], q[1], q[2], q[6], q[4], q[5], q[8], q[5], q[7]);
+        p[1] = -det3(q[0], q[3], q[2], q[1], q[6], q[5], q[2], q[8], q[7]);
+        p[2] = -det3(q[0], q[1], q[3], q[1], q[4], q[6], q[2], q[5], q[8]);
+        for (int i = 0; i < 3; i++)
+            p[i] /= det;
+        return quadric_error(q, p);
+    }
+
+    // Otherwise the best of the ends and the midpoint
+    double mid[3];
+    for (int i = 0; i < 3; i++)
+        mid[i] = (v0->p[i] + v1->p[i]) / 2;
+    const double *candidates[3] = {v0->p, v1->p, mid};
+    double best = DBL_MAX;
+    for (int i = 0; i < 3; i++) {
+        double err = quadric_error(q, candidates[i]);
+        if (err < best) {
+            best = err;
+            memcpy(p, candidates[i], sizeof(double[3]));
+        }
+    }
+    return best;
+}
+
+static void simplify_tri_error(const struct simplify *const s,
+                               struct simp_tri *const t) {
+    double p[3];
+    for (int j = 0; j < 3; j++)
+        t->err[j] = simplify_edge_error(s, t->v[j], t->v[(j + 1) % 3], p);
+    t->err[3] = MIN(MIN(t->err[0], t->err[1]), t->err[2]);
+}
+
+/**
+ * Whether moving vertex i0 to p flips or degenerates one of its faces that
+ * does not also contain i1. Faces containing both are marked in collapsed.
+ */
+static bool simplify_flips(const struct simplify *const s, const double p[3],
+                           uint32_t i0, uint32_t i1, bool *collapsed) {
+    const struct simp_vertex *v0 = &s->vertices[i0];
+    const struct simp_ref *refs = s->refs.data;
+    const struct simp_tri *tris = s->tris.data;
+    for (uint32_t k = 0; k < v0->tcount; k++) {
+        const struct simp_ref *ref = &refs[v0->tstart + k];
+        const struct simp_tri *t = &tris[ref->tri];
+        if (t->deleted)
+            continue;
+
+        uint32_t id1 = t->v[(ref->corner + 1) % 3];
+        uint32_t id2 = t->v[(ref->corner + 2) % 3];
+        if (id1 == i1 || id2 == i1) {
+            collapsed[k] = true;
+            continue;
+        }
+        collapsed[k] = false;
+
+        double d1[3], d2[3], n[3];
+        vec3d_sub(s->vertices[id1].p, p, d1);
+        vec3d_normalize(d1);
+        vec3d_sub(s->vertices[id2].p, p, d2);
+        vec3d_normalize(d2);
+        if (fabs(vec3d_dot(d1, d2)) > 0.999)
+            return true;
+        vec3d_cross(d1, d2, n);
+        vec3d_normalize(n);
+        if (vec3d_dot(n, t->n) < 0.2)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Points the faces of v at i0 after a collapse into it, drops the faces in
+ * collapsed and appends the references of the rest to s->refs. Returns
+ * -ENOMEM when s->refs cannot grow.
+ */
+static int simplify_move_faces(struct simplify *const s, uint32_t i0,
+                                const struct simp_vertex *const v,
+                                const bool *collapsed, size_t *deleted) {
+    for (uint32_t k = 0; k < v->tcount; k++) {
+        struct simp_ref ref =
+            ((struct simp_ref *)s->refs.data)[v->tstart + k];
+        struct simp_tri *t = &((struct simp_tri *)s->tris.data)[ref.tri];
+        if (t->deleted)
+            continue;
+        if (collapsed[k]) {
+            t->deleted = true;
+            (*deleted)++;
+            continue;
+        }
+
+        t->v[ref.corner] = i0;
+        t->dirty = true;
+        simplify_tri_error(s, t);
+        int ret = array_push(&s->refs, &ref, sizeof(ref));
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+/**
+ * Drops deleted faces and rebuilds the face references of every vertex. The
+ * first time through it also finds the border vertices and sets up the
+ * quadrics and collapse errors.
+ */
+static int simplify_rebuild(struct simplify *const s, bool first) {
+    struct simp_tri *tris = s->tris.data;
+    size_t tri_count = 0;
+    for (size_t i = 0; i < s->tris.count; i++) {
+        if (!tris[i].deleted)
+            tris[tri_count++] = tris[i];
+    }
+    s->tris.count = tri_count;
+
+    for (size_t i = 0; i < s->vertex_count; i++) {
+        s->vertices[i].tstart = 0;
+        s->vertices[i].tcount = 0;
+    }
+    for (size_t i = 0; i < tri_count; i++) {
+        for (int j = 0; j < 3; j++)
+            s->vertices[tris[i].v[j]].tcount++;
+    }
+    uint32_t tstart = 0;
+    for (size_t i = 0; i < s->vertex_count; i++) {
+        s->vertices[i].tstart = tstart;
+        tstart += s->vertices[i].tcount;
+        s->vertices[i].tcount = 0;
+    }
+    if (s->refs.capacity < tri_count * 3) {
+        int ret = ARRAY_RESIZE(struct simp_ref, &s->refs, tri_count * 3);
+        if (ret < 0)
+            return ret;
+    }
+    struct simp_ref *refs = s->refs.data;
+    for (size_t i = 0; i < tri_count; i++) {
+        for (uint32_t j = 0; j < 3; j++) {
+            struct simp_vertex *v = &s->vertices[tris[i].v[j]];
+            refs[v->tstart + v->tcount++] = (struct simp_ref){i, j};
+        }
+    }
+    s->refs.count = tri_count * 3;
+
+    if (!first)
+        return 0;
+
+    // An edge only one face uses is on the border. Count the edges to each
+    // neighbour of every vertex.
+    size_t max_valence = 0;
+    for (size_t i = 0; i < s->vertex_count; i++)
+        max_valence = MAX(max_valence, s->vertices[i].tcount);
+    uint32_t *ids = heap_malloc(max_valence * 2 * sizeof(uint32_t));
+    uint32_t *counts = heap_malloc(max_valence * 2 * sizeof(uint32_t));
+    if (max_valence > 0 && (!ids || !counts)) {
+        free(ids);
+        free(counts);
+        return -ENOMEM;
+    }
+    for (size_t i = 0; i < s->vertex_count; i++) {
+        const struct simp_vertex *v = &s->vertices[i];
+        size_t n = 0;
+        for (uint32_t k = 0; k < v->tcount; k++) {
+            const struct simp_tri *t = &tris[refs[v->tstart + k].tri];
+            for (int j = 0; j < 3; j++) {
+                uint32_t id = t->v[j];
+                size_t m = 0;
+                while (m < n && ids[m] != id)
+                    m++;
+                if (m == n) {
+                    ids[n] = id;
+                    counts[n++] = 0;
+                }
+                counts[m]++;
+            }
+        }
+        for (size_t m = 0; m < n; m++) {
+            if (counts[m] == 1)
+                s->vertices[ids[m]].border = true;
+        }
+    }
+    free(ids);
+    free(counts);
+
+    for (size_t i = 0; i < tri_count; i++) {
+        struct simp_tri *t = &tris[i];
+        double e1[3], e2[3];
+        const double *p0 = s->vertices[t->v[0]].p;
+        vec3d_sub(s->vertices[t->v[1]].p, p0, e1);
+        vec3d_sub(s->vertices[t->v[2]].p, p0, e2);
+        vec3d_cross(e1, e2, t->n);
+        vec3d_normalize(t->n);
 
-        if (ry0 > ry1) {
-            SWAP(uint32_t, ry0, ry1);
+        double q[10];
+        quadric_plane(q, t->n[0], t->n[1], t->n[2], -vec3d_dot(t->n, p0));
+        for (int j = 0; j < 3; j++) {
+            double *vq = s->vertices[t->v[j]].q;
+            for (int k = 0; k < 10; k++)
+                vq[k] += q[k];
         }
+    }
+    for (size_t i = 0; i < tri_count; i++)
+        simplify_tri_error(s, &tris[i]);
+    return 0;
+}
 
-        for (uint32_t iy = ry0; iy <= ry1 || (iy < 0 && iy >= canvas->height);
-             iy++) {
-            for (uint32_t x_thicc = ix; x_thicc < ix + thiccness; x_thicc++) {
+static int simplify_reserve_collapsed(struct simplify *const s, size_t n) {
+    if (n <= s->collapsed_capacity)
+        return 0;
+    n = MAX(n, s->collapsed_capacity * 2);
+    for (int i = 0; i < 2; i++) {
+        bool *data = heap_realloc(s->collapsed[i], n * sizeof(bool));
+        if (!data)
+            return -ENOMEM;
+        s->collapsed[i] = data;
+    }
+    s->collapsed_capacity = n;
+    return 0;
+}
 
-                if (iy < canvas->height && x_thicc < canvas->width) {
-                    ret = canvas_blend_px(canvas, x_thicc, iy, color);
-                    if (ret < 0)
-                        return ret;
-                }
-            }
+/**
+ * Collapses edges until at most target faces are left or the passes run out.
+ */
+static int simplify_run(struct simplify *const s, size_t target) {
+    size_t start_count = s->tris.count;
+    size_t deleted = 0;
+    for (int pass = 0; pass < SIMPLIFY_MAX_PASSES; pass++) {
+        if (start_count - deleted <= target)
+            break;
+        if (pass % SIMPLIFY_REBUILD_PASSES == 0) {
+            int ret = simplify_rebuild(s, pass == 0);
+            if (ret < 0)
+                return ret;
+            start_count = s->tris.count;
+            deleted = 0;
         }
 
-        for (uint32_t y_thicc = ry0; y_thicc < ry0 + thiccness; y_thicc++) {
-            if (y_thicc < canvas->height && ix < canvas->width) {
-                ret = canvas_blend_px(canvas, ix, y_thicc, color);
+        struct simp_tri *tris = s->tris.data;
+        for (size_t i = 0; i < s->tris.count; i++)
+            tris[i].dirty = false;
+
+        // Scaled for meshes of about unit size, which simplify_init makes
+        double threshold = 1e-9 * pow(pass + 3, SIMPLIFY_AGGRESSIVENESS);
+        for (size_t i = 0; i < s->tris.count; i++) {
+            struct simp_tri *t = &((struct simp_tri *)s->tris.data)[i];
+            if (t->err[3] > threshold || t->deleted || t->dirty)
+                continue;
+
+            for (int j = 0; j < 3; j++) {
+                if (t->err[j] > threshold)
+                    continue;
+                uint32_t i0 = t->v[j];
+                uint32_t i1 = t->v[(j + 1) % 3];
+                struct simp_vertex *v0 = &s->vertices[i0];
+                struct simp_vertex *v1 = &s->vertices[i1];
+                if (v0->border != v1->border)
+                    continue;
+
+                double p[3];
+                simplify_edge_error(s, i0, i1, p);
+                int ret = simplify_reserve_collapsed(
+                    s, MAX(v0->tcount, v1->tcount));
+                if (ret < 0)
+                    return ret;
+                if (simplify_flips(s, p, i0, i1, s->collapsed[0]) ||
+                    simplify_flips(s, p, i1, i0, s->collapsed[1]))
+                    continue;
+
+                memcpy(v0->p, p, sizeof(p));
+                for (int k = 0; k < 10; k++)
+                    v0->q[k] += v1->q[k];
+
+                // The faces of both ends move to the end of the references
+                size_t tstart = s->refs.count;
+                ret = simplify_move_faces(s, i0, v0, s->collapsed[0],
+                                          &deleted);
+                if (ret == 0)
+                    ret = simplify_move_faces(s, i0, v1, s->collapsed[1],
+                                              &deleted);
                 if (ret < 0)
                     return ret;
+                v0->tstart = (uint32_t)tstart;
+                v0->tcount = (uint32_t)(s->refs.count - tstart);
+                break;
             }
+            if (start_count - deleted <= target)
+                break;
         }
     }
+    return simplify_rebuild(s, false);
+}
+
+struct weld_key {
+    float p[3];
+    uint32_t index;
+};
 
+static int weld_key_cmp(const void *a, const void *b) {
+    const struct weld_key *ka = a;
+    const struct weld_key *kb = b;
+    for (int i = 0; i < 3; i++) {
+        if (ka->p[i] != kb->p[i])
+            return ka->p[i] < kb->p[i] ? -1 : 1;
+    }
     return 0;
 }
 
-// 3D
+/**
+ * Sets up s with the vertices of obj welded by position, moved into a unit
+ * box around the origin, and its faces that still have three vertices.
+ */
+static int simplify_init(struct simplify *const s, const obj_t *const obj,
+                         const double center[3], double scale) {
+    size_t vertex_count = obj_vertex_count(obj);
+    *s = (struct simplify){0};
+    struct weld_key *keys = heap_malloc(vertex_count * sizeof(*keys));
+    uint32_t *weld = heap_malloc(vertex_count * sizeof(uint32_t));
+    s->vertices = heap_calloc(vertex_count, sizeof(struct simp_vertex));
+    if (!keys || !weld || !s->vertices) {
+        free(keys);
+        free(weld);
+        return -ENOMEM;
+    }
 
-void tri_interp_rgb_depth(canvas_t *const canvas, int64_t x, int64_t y, float u,
-                          float v, float w, void *ctx) {
-    point3_t *vertices = (point3_t *)ctx;
-    struct rgba color = color_lerp_rgb(u, v, w);
-    float z = vertices[0].z * u + vertices[1].z * v + vertices[2].z * w;
+    for (size_t i = 0; i < vertex_count; i++)
+        keys[i] = (struct weld_key){{obj->x[i], obj->y[i], obj->z[i]}, i};
+    qsort(keys, vertex_count, sizeof(*keys), &weld_key_cmp);
+    for (size_t i = 0; i < vertex_count; i++) {
+        if (i == 0 || weld_key_cmp(&keys[i - 1], &keys[i]) != 0) {
+            struct simp_vertex *v = &s->vertices[s->vertex_count++];
+            for (int j = 0; j < 3; j++)
+                v->p[j] = (keys[i].p[j] - center[j]) * scale;
+        }
+        weld[keys[i].index] = (uint32_t)(s->vertex_count - 1);
+    }
+    free(keys);
 
-    if (z >= canvas->depth[y * canvas->width + x])
-        return;
+    size_t face_count = MAX(obj_face_count(obj), 1);
+    int ret = ARRAY_MAKE(&s->tris, struct simp_tri, face_count);
+    if (ret == 0)
+        ret = ARRAY_MAKE(&s->refs, struct simp_ref, face_count * 3);
+    if (ret < 0) {
+        free(weld);
+        return ret;
+    }
+    for (size_t i = 0; i < obj_face_count(obj); i++) {
+        const uint32_t *face = obj_face(obj, i);
+        if (face[0] >= vertex_count || face[1] >= vertex_count ||
+            face[2] >= vertex_count) {
+            free(weld);
+            return -EINVAL;
+        }
 
-    canvas_blend_px(canvas, x, y, color);
-    canvas->depth[y * canvas->width + x] = z;
+        struct simp_tri t = {
+            .v = {weld[face[0]], weld[face[1]], weld[face[2]]},
+        };
+        if (t.v[0] == t.v[1] || t.v[1] == t.v[2] || t.v[2] == t.v[0])
+            continue;
+        ret = array_push(&s->tris, &t, sizeof(t));
+        if (ret < 0) {
+            free(weld);
+            return ret;
+        }
+    }
+    free(weld);
+    return 0;
 }
 
-int canvas_proj_tri(canvas_t *const canvas, point3_t *const vertices,
-                    struct camera cam) {
+static void simplify_cleanup(struct simplify *const s) {
+    free(s->vertices);
+    free(s->collapsed[0]);
+    free(s->collapsed[1]);
+    array_cleanup(&s->tris);
+    array_cleanup(&s->refs);
+}
 
-    point2_t proj[3] = {
-        point3_proj(vertices[0], cam),
-        point3_proj(vertices[1], cam),
-        point3_proj(vertices[2], cam),
+/**
+ * Writes a simplified copy of obj with at most about target_faces faces to
+ * out. Vertices at the same position are merged, and the vertices left are
+ * numbered in order of first use. The result may keep more faces when no
+ * more can be removed without flipping some.
+ */
+int obj_simplify(const obj_t *const obj, obj_t *const out,
+                 size_t target_faces) {
+    double center[3] = {
+        ((double)obj->bounds_min.x + obj->bounds_max.x) / 2,
+        ((double)obj->bounds_min.y + obj->bounds_max.y) / 2,
+        ((double)obj->bounds_min.z + obj->bounds_max.z) / 2,
     };
+    double extent = MAX(MAX(obj->bounds_max.x - obj->bounds_min.x,
+                            obj->bounds_max.y - obj->bounds_min.y),
+                        obj->bounds_max.z - obj->bounds_min.z);
+    double scale = extent > 0 ? 1 / extent : 1;
 
-    for (int i = 0; i < 3; i++) {
-        if (!canvas_point_in_range(canvas, proj[i].x, proj[i].y))
-            return -EINVAL;
+    struct simplify s;
+    int ret = simplify_init(&s, obj, center, scale);
+    if (ret == 0)
+        ret = simplify_run(&s, target_faces);
+    if (ret == 0)
+        ret = obj_init(out);
+    if (ret < 0) {
+        simplify_cleanup(&s);
+        return ret;
     }
 
-    calc_tri_barycentric(canvas, proj[0], proj[1], proj[2],
-                         &tri_interp_rgb_depth, vertices);
-}
+    uint32_t *remap = heap_malloc(MAX(s.vertex_count, 1) * sizeof(uint32_t));
+    if (!remap) {
+        simplify_cleanup(&s);
+        obj_cleanup(out);
+        return -ENOMEM;
+    }
+    for (size_t i = 0; i < s.vertex_count; i++)
+        remap[i] = UINT32_MAX;
 
-/* Text */
+    const struct simp_tri *tris = s.tris.data;
+    for (size_t i = 0; i < s.tris.count && ret == 0; i++) {
+        size_t face[3];
+        for (int j = 0; j < 3 && ret == 0; j++) {
+            uint32_t id = tris[i].v[j];
+            if (remap[id] == UINT32_MAX) {
+                const double *p = s.vertices[id].p;
+                remap[id] = (uint32_t)obj_vertex_count(out);
+                ret = obj_add_vertex(out, (float)(p[0] / scale + center[0]),
+                                     (float)(p[1] / scale + center[1]),
+                                     (float)(p[2] / scale + center[2]));
+            }
+            face[j] = (size_t)remap[id] + 1;
+        }
+        if (ret == 0)
+            ret = obj_add_face(out, face[0], face[1], face[2]);
+    }
 
-const char *font_get_glyph(font_t font, char c) {
-    return &font.glyphs[c * sizeof(char) * font.glyph_width *
-                        font.glyph_height];
+    free(remap);
+    simplify_cleanup(&s);
+    if (ret < 0)
+        obj_cleanup(out);
+    return ret;
 }
 
 /**
- * Draws a character at point (x, y).
+ * Builds a level of detail chain from obj, which becomes its first level and
+ * belongs to the chain from then on. Each further level is simplified from
+ * obj to about half the faces of the one before, down to min_faces or
+ * LOD_MAX_LEVELS levels.
  */
-void canvas_draw_char(canvas_t *const canvas, char c, uint32_t x, uint32_t y,
-                      font_t font, uint32_t font_size, struct rgba color) {
-    const char *glyph = font_get_glyph(font, c);
-    uint32_t end_x = x + font_size * font.glyph_width - 1;
-    uint32_t end_y = y + font_size * font.glyph_height - 1;
-    assert(end_x < canvas->width && end_y < canvas->height);
-
-    for (uint32_t ix = x; ix <= end_x; ix++) {
-        for (uint32_t iy = y; iy <= end_y; iy++) {
-            uint32_t i_glyph = ((iy - y) / font_size) * font.glyph_width +
-                               ((ix - x) / font_size);
-            if (glyph[i_glyph] == 1) {
-                canvas_blend_px(canvas, ix, iy, color);
-            }
+int lod_build(lod_t *const lod, obj_t *const obj, size_t min_faces) {
+    *lod = (lod_t){.level_count = 1};
+    lod->levels[0] = *obj;
+    *obj = (obj_t){0};
+
+    while (lod->level_count < LOD_MAX_LEVELS) {
+        size_t prev = obj_face_count(&lod->levels[lod->level_count - 1]);
+        if (prev / 2 < min_faces)
+            break;
+
+        obj_t *level = &lod->levels[lod->level_count];
+        int ret = obj_simplify(&lod->levels[0], level, prev / 2);
+        if (ret < 0) {
+            lod_cleanup(lod);
+            return ret;
+        }
+
+        // Stop once simplification stalls
+        if (obj_face_count(level) > prev * 3 / 4) {
+            obj_cleanup(level);
+            break;
         }
+        lod->level_count++;
     }
+    return 0;
+}
+
+void lod_cleanup(lod_t *const lod) {
+    for (size_t i = 0; i < lod->level_count; i++)
+        obj_cleanup(&lod->levels[i]);
+    *lod = (lod_t){0};
 }
 
 /**
- * Writes text to the canvas starting at point (x, y).
+ * Mesh caches
+ *
+ * A mesh cache holds an obj_t as it sits in memory: a header followed by the
+ * x, y and z arrays and the indices, each starting on an OBJ_ALIGN boundary
+ * and padded to a multiple of it. obj_map_cache maps the file and points the
+ * obj_t straight at those sections, so loading costs the same for any mesh
+ * size. Caches use the native byte order and record the size and modification
+ * time of the OBJ file they were made from, so edits to it invalidate them.
  */
-void canvas_write_string(canvas_t *const canvas, const char *str, uint32_t x,
-                         uint32_t y, font_t font, uint32_t font_size,
-                         struct rgba color) {
-    uint32_t len = strlen(str);
-    if (len == 0)
-        return;
-    assert(x + len * font.glyph_width < canvas->width &&
-           y + font.glyph_height < canvas->height);
 
-    for (uint32_t i = 0; i < len; i++) {
-        char c = str[i];
-        uint32_t ix = x + i * font_size * font.glyph_width;
-        canvas_draw_char(canvas, c, ix, y, font, font_size, color);
-    }
+#define MESH_CACHE_MAGIC "MOLUVIM"
+#define MESH_CACHE_VERSION 1
+#define MESH_CACHE_BYTE_ORDER 0x01020304u
+#define MESH_CACHE_SUFFIX ".mesh"
+
+struct mesh_cache_header {
+    char magic[8];
+    uint32_t version;    // MESH_CACHE_VERSION
+    uint32_t byte_order; // MESH_CACHE_BYTE_ORDER, as written
+    uint64_t file_size;
+    uint64_t vertex_count;
+    uint64_t face_count;
+    uint64_t x_offset; // Byte offsets of the sections from the file start
+    uint64_t y_offset;
+    uint64_t z_offset;
+    uint64_t index_offset;
+    point3_t bounds_min;
+    point3_t bounds_max;
+
+    // The OBJ file the cache was made from
+    uint64_t source_size;
+    int64_t source_mtime_sec;
+    int64_t source_mtime_nsec;
+};
+
+static inline uint64_t mesh_cache_align(uint64_t bytes) {
+    return (bytes + OBJ_ALIGN - 1) / OBJ_ALIGN * OBJ_ALIGN;
+}
+
+static int mesh_cache_stat_source(const char *source_path,
+                                  struct mesh_cache_header *header) {
+    struct stat st;
+    if (stat(source_path, &st) < 0)
+        return -errno;
+
+    header->source_size = (uint64_t)st.st_size;
+#ifdef __APPLE__
+    header->source_mtime_sec = st.st_mtimespec.tv_sec;
+    header->source_mtime_nsec = st.st_mtimespec.tv_nsec;
+#else
+    header->source_mtime_sec = st.st_mtim.tv_sec;
+    header->source_mtime_nsec = st.st_mtim.tv_nsec;
+#endif
+    return 0;
+}
+
+static bool mesh_cache_write_section(FILE *file, const void *data,
+                                     size_t bytes) {
+    static const char zeros[OBJ_ALIGN];
+    size_t padding = mesh_cache_align(bytes) - bytes;
+    return fwrite(data, 1, bytes, file) == bytes &&
+           fwrite(zeros, 1, padding, file) == padding;
 }
 
 /**
- * Renders a canvas to a file in PPM P6 format.
+ * Writes obj to a mesh cache at cache_path, recording source_path as the OBJ
+ * file it came from. The cache is written to a temporary file first and
+ * renamed into place, so readers never see half of it.
  */
-void canvas_render_ppm(const canvas_t *const canvas, const char *filename) {
-    FILE *file = fopen(filename, "wb");
+int obj_write_cache(const obj_t *const obj, const char *cache_path,
+                    const char *source_path) {
+    struct mesh_cache_header header = {
+        .magic = MESH_CACHE_MAGIC,
+        .version = MESH_CACHE_VERSION,
+        .byte_order = MESH_CACHE_BYTE_ORDER,
+        .vertex_count = obj->vertex_count,
+        .face_count = obj->face_count,
+        .bounds_min = obj->bounds_min,
+        .bounds_max = obj->bounds_max,
+    };
+    int ret = mesh_cache_stat_source(source_path, &header);
+    if (ret < 0)
+        return ret;
+
+    uint64_t coord_bytes = mesh_cache_align(obj->vertex_count * sizeof(float));
+    header.x_offset = mesh_cache_align(sizeof(header));
+    header.y_offset = header.x_offset + coord_bytes;
+    header.z_offset = header.y_offset + coord_bytes;
+    header.index_offset = header.z_offset + coord_bytes;
+    header.file_size =
+        header.index_offset +
+        mesh_cache_align(obj->face_count * 3 * sizeof(uint32_t));
+
+    size_t path_len = strlen(cache_path);
+    char *tmp_path = heap_malloc(path_len + sizeof(".XXXXXX"));
+    if (!tmp_path)
+        return -ENOMEM;
+    memcpy(tmp_path, cache_path, path_len);
+    memcpy(tmp_path + path_len, ".XXXXXX", sizeof(".XXXXXX"));
+
+    int fd = mkstemp(tmp_path);
+    if (fd >= 0)
+        fchmod(fd, 0644);
+    FILE *file = fd >= 0 ? fdopen(fd, "wb") : NULL;
     if (!file) {
-        perror("Could not open file");
-        return;
+        ret = -errno;
+        if (fd >= 0) {
+            close(fd);
+            unlink(tmp_path);
+        }
+        free(tmp_path);
+        return ret;
     }
 
-    fprintf(file, "P6\n%u %u 255\n", canvas->width, canvas->height);
-    for (uint32_t i = 0; i < canvas->width * canvas->height; i++) {
-        struct rgba color = canvas->data[i];
-        fwrite(&color.r, sizeof(uint8_t), 1, file);
-        fwrite(&color.g, sizeof(uint8_t), 1, file);
-        fwrite(&color.b, sizeof(uint8_t), 1, file);
-    }
-    fclose(file);
+    bool ok =
+        mesh_cache_write_section(file, &header, sizeof(header)) &&
+        mesh_cache_write_section(file, obj->x, obj->vertex_count * 4) &&
+        mesh_cache_write_section(file, obj->y, obj->vertex_count * 4) &&
+        mesh_cache_write_section(file, obj->z, obj->vertex_count * 4) &&
+        mesh_cache_write_section(file, obj->indices, obj->face_count * 12);
+    ok = fclose(file) == 0 && ok;
+    if (!ok)
+        ret = -EIO;
+    else if (rename(tmp_path, cache_path) < 0)
+        ret = -errno;
+
+    if (ret < 0)
+        unlink(tmp_path);
+    free(tmp_path);
+    return ret;
+}
+
+static bool mesh_cache_section_valid(const struct mesh_cache_header *header,
+                                     uint64_t offset, uint64_t bytes) {
+    return offset % OBJ_ALIGN == 0 && offset <= header->file_size &&
+           mesh_cache_align(bytes) <= header->file_size - offset;
 }
 
 /**
- * Loads a canvas from PPM P6 file.
+ * Maps the mesh cache at cache_path into obj without copying it. Returns
+ * -ESTALE if source_path changed since the cache was written, and -EINVAL if
+ * the file is not a cache of this version. The mapped obj_t is read-only and
+ * is released with obj_cleanup.
  */
-canvas_t canvas_load_ppm(const char *filename) {
-    FILE *file = fopen(filename, "rb");
-    if (!file) {
-        perror("Could not load canvas");
-        exit(1);
+int obj_map_cache(obj_t *const obj, const char *cache_path,
+                  const char *source_path) {
+    struct mesh_cache_header source = {0};
+    int ret = mesh_cache_stat_source(source_path, &source);
+    if (ret < 0)
+        return ret;
+
+    int fd = open(cache_path, O_RDONLY);
+    if (fd < 0)
+        return -errno;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        ret = -errno;
+        close(fd);
+        return ret;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size < sizeof(struct mesh_cache_header)) {
+        close(fd);
+        return -EINVAL;
     }
 
-    char *token = NULL;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return -errno;
 
-    // Parse format
-    char line[32];
-    if (!fgets(line, sizeof(line), file)) {
-        perror("Could not read format from file");
-        exit(1);
+    const struct mesh_cache_header *header = mapping;
+    uint64_t coord_bytes = header->vertex_count * sizeof(float);
+    uint64_t index_bytes = header->face_count * 3 * sizeof(uint32_t);
+    if (memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != MESH_CACHE_VERSION ||
+        header->byte_order != MESH_CACHE_BYTE_ORDER ||
+        header->file_size != size ||
+        header->vertex_count > UINT32_MAX ||
+        header->face_count > SIZE_MAX / 12 ||
+        !mesh_cache_section_valid(header, header->x_offset, coord_bytes) ||
+        !mesh_cache_section_valid(header, header->y_offset, coord_bytes) ||
+        !mesh_cache_section_valid(header, header->z_offset, coord_bytes) ||
+        !mesh_cache_section_valid(header, header->index_offset, index_bytes)) {
+        munmap(mapping, size);
+        return -EINVAL;
     }
-    printf("LOADING CANVAS FROM FILE %s, FORMAT=%s", filename, line);
 
-    token = strtok(line, "\n");
-    if (strcmp(token, "P6") != 0) {
-        perror("MLCanvasLoadPPM currently only supports P6 format\n");
-        exit(1);
+    if (header->source_size != source.source_size ||
+        header->source_mtime_sec != source.source_mtime_sec ||
+        header->source_mtime_nsec != source.source_mtime_nsec) {
+        munmap(mapping, size);
+        return -ESTALE;
     }
 
-    // Parse size and (ignored for now) color depth
-    uint32_t width;
-    uint32_t height;
-    uint16_t bit_depth;
+    char *base = mapping;
+    size_t block = OBJ_ALIGN / sizeof(float);
+    *obj = (obj_t){
+        .x = (float *)(base + header->x_offset),
+        .y = (float *)(base + header->y_offset),
+        .z = (float *)(base + header->z_offset),
+        .vertex_count = header->vertex_count,
+        .vertex_capacity = (header->vertex_count + block - 1) / block * block,
+        .indices = (uint32_t *)(base + header->index_offset),
+        .face_count = header->face_count,
+        .face_capacity = header->face_count,
+        .bounds_min = header->bounds_min,
+        .bounds_max = header->bounds_max,
+        .mapping = mapping,
+        .mapping_size = size,
+    };
+    return 0;
+}
 
-    if (!fgets(line, sizeof(line), file)) {
-        perror("Could not read size/color depth from file");
-        exit(1);
+/**
+ * Loads an OBJ file through the mesh cache next to it (filename + ".mesh").
+ * A missing or stale cache is rebuilt from the OBJ file; failing to write it
+ * only costs the next load a parse.
+ */
+int obj_load_cached(obj_t *const obj, const char *filename) {
+    size_t len = strlen(filename);
+    char *cache_path = heap_malloc(len + sizeof(MESH_CACHE_SUFFIX));
+    if (!cache_path)
+        return -ENOMEM;
+    memcpy(cache_path, filename, len);
+    memcpy(cache_path + len, MESH_CACHE_SUFFIX, sizeof(MESH_CACHE_SUFFIX));
+
+    int ret = obj_map_cache(obj, cache_path, filename);
+    if (ret < 0) {
+        ret = obj_load(obj, filename);
+        if (ret == 0 && obj_write_cache(obj, cache_path, filename) < 0)
+            fprintf(stderr, "WARNING: Could not write mesh cache %s\n",
+                    cache_path);
     }
 
-    token = strtok(line, " ");
-    width = atoi(token);
-    token = strtok(NULL, " ");
-    height = atoi(token);
-    token = strtok(NULL, " ");
-    bit_depth = atoi(token);
-    printf("CANVAS WIDTH=%u, HEIGHT=%u, BIT_DEPTH=%u\n", width, height,
-           bit_depth);
+    free(cache_path);
+    return ret;
+}
 
-    // Interpret bytes as colors (struct rgba)
-    struct rgba *data = malloc(sizeof(struct rgba) * width * height);
-    if (!data) {
-        perror("Could not allocate data\n");
-        exit(1);
-    }
-    char *raw_data = (char *)malloc(3 * width * height);
-    if (!raw_data) {
-        perror("Could not allocate raw data\n");
-        exit(1);
-    }
+/**
+ * Frame arenas
+ *
+ * An arena hands out memory by bumping an offset into one block and gets it
+ * all back at once with arena_reset, so scratch that lives for a frame costs
+ * no heap allocation once the arena is set up.
+ */
 
-    size_t bytes_read = fread(raw_data, 1, 3 * width * height, file);
-    if (bytes_read != 3 * width * height) {
-        perror("Could not read enough bytes\n");
-        printf("Bytes read %lu\n", bytes_read);
-        exit(1);
-    }
+int arena_init(arena_t *const arena, size_t size) {
+    *arena = (arena_t){.size = size};
+    arena->base = heap_aligned_alloc(
+        CANVAS_ALIGN, (size + CANVAS_ALIGN - 1) / CANVAS_ALIGN * CANVAS_ALIGN);
+    return arena->base ? 0 : -ENOMEM;
+}
 
-    for (uint32_t i = 0; i < width * height; i++) {
-        struct rgba color = {0};
-        color.r = raw_data[i * 3 + 0];
-        color.g = raw_data[i * 3 + 1];
-        color.b = raw_data[i * 3 + 2];
-        color.a = 0xFF;
-        data[i] = color;
-    }
+/**
+ * Returns size bytes aligned to align, a power of two no larger than
+ * CANVAS_ALIGN, or NULL once the arena is full.
+ */
+void *arena_alloc(arena_t *const arena, size_t size, size_t align) {
+    size_t offset = (arena->used + align - 1) & ~(align - 1);
+    if (offset > arena->size || size > arena->size - offset)
+        return NULL;
+    arena->used = offset + size;
+    arena->peak = MAX(arena->peak, arena->used);
+    return arena->base + offset;
+}
 
-    fclose(file);
+/**
+ * Releases everything allocated from the arena since the last reset.
+ */
+void arena_reset(arena_t *const arena) { arena->used = 0; }
 
-    return (canvas_t){.width = width, .height = height, .data = data};
+void arena_cleanup(arena_t *const arena) {
+    free(arena->base);
+    *arena = (arena_t){0};
 }
 
-int obj_init(obj_t *const obj) {
-    int ret;
-    ret = ARRAY_MAKE(&obj->vertices, float, 256);
-    if (ret < 0)
-        return ret;
-    ret = ARRAY_MAKE(&obj->faces, size_t, 512);
-    if (ret < 0)
-        return ret;
-    return 0;
+static void *arena_allocator_alloc(void *ctx, size_t size, size_t align) {
+    return arena_alloc((arena_t *)ctx, size, align);
 }
 
-int obj_load(obj_t *const obj, const char *filename) {
-    int ret;
-    FILE *obj_file = fopen(filename, "r");
-    if (!obj_file) {
-        fprintf(stderr, "Could not open vendor/teapot.obj");
-        exit(1);
-    }
+/**
+ * Returns an allocator handing out memory from arena. Its frees do nothing;
+ * the memory comes back on arena_reset.
+ */
+struct allocator arena_allocator(arena_t *const arena) {
+    return (struct allocator){.alloc = &arena_allocator_alloc, .ctx = arena};
+}
 
-    ret = obj_init(obj);
-    if (ret < 0)
-        return ret;
+/**
+ * Canvas pool
+ *
+ * Released canvases keep their pixels and scratch space, and are handed out
+ * again to the next request of the same size. Everything else a canvas
+ * picks up while in use (its depth buffer and format, pending clears, dirty
+ * tracking) is dropped, so a reused canvas behaves exactly like a new one.
+ */
 
-    char type;
-    float x, y, z;
-    while (fscanf(obj_file, "%c %f %f %f\n", &type, &x, &y, &z) == 4) {
-        // printf("type = %c, %f %f %f\n", type, x, y, z);
-        if (type == 'v') {
-            obj_add_vertex(obj, x, y, z);
-        } else if (type == 'f') {
-            obj_add_face(obj, (size_t)x, (size_t)y, (size_t)z);
-        } else {
-            fprintf(stderr, "WARNING: Unsupported obj_t type '%c' found\n",
-                    type);
-        }
-    }
+int canvas_pool_init(canvas_pool_t *const pool,
+                     const struct allocator *const alloc) {
+    pool->alloc = alloc;
+    return ARRAY_MAKE(&pool->idle, canvas_t, 4);
+}
 
-    return 0;
+/**
+ * Initializes canvas like canvas_init_with the pool's allocator, reusing the
+ * pixels of a released canvas of the same size when there is one.
+ */
+int canvas_pool_acquire(canvas_pool_t *const pool, canvas_t *const canvas,
+                        uint32_t width, uint32_t height, struct rgba fill) {
+    canvas_t *idle = pool->idle.data;
+    for (size_t i = 0; i < pool->idle.count; i++) {
+        if (idle[i].width != width || idle[i].height != height)
+            continue;
+        canvas_t used = idle[i];
+        idle[i] = idle[--pool->idle.count];
+
+        const struct allocator *alloc = used.alloc;
+        canvas_buffer_free(alloc, used.depth, depth_buffer_size(&used));
+        mem_free(alloc, used.depth_tiles);
+        mem_free(alloc, used.clear_tiles);
+        mem_free(alloc, used.dirty_tiles);
+        *canvas = (canvas_t){
+            .width = used.width,
+            .height = used.height,
+            .stride = used.stride,
+            .data = used.data,
+            .mesh_scratch = used.mesh_scratch,
+            .alloc = alloc,
+        };
+        span_set(canvas->data, (size_t)canvas->stride * height, fill);
+        return 0;
+    }
+    return canvas_init_with(canvas, width, height, fill, pool->alloc);
 }
 
-inline size_t obj_vertex_count(const obj_t *const obj) {
-    return obj->vertices.count / 3;
+/**
+ * Hands canvas back to the pool for reuse. canvas must have come from
+ * canvas_pool_acquire, and is left empty. When the pool cannot grow, canvas
+ * is freed instead and -ENOMEM returned.
+ */
+int canvas_pool_release(canvas_pool_t *const pool, canvas_t *const canvas) {
+    int ret = array_push(&pool->idle, canvas, sizeof(*canvas));
+    if (ret < 0)
+        canvas_cleanup(canvas);
+    *canvas = (canvas_t){0};
+    return ret;
 }
 
-inline size_t obj_face_count(const obj_t *const obj) {
-    return obj->faces.count / 3;
+void canvas_pool_cleanup(canvas_pool_t *const pool) {
+    canvas_t *idle = pool->idle.data;
+    for (size_t i = 0; i < pool->idle.count; i++)
+        canvas_cleanup(&idle[i]);
+    array_cleanup(&pool->idle);
+    pool->idle = (arraylist_t){0};
 }
 
-void obj_add_vertex(obj_t *const obj, float x, float y, float z) {
-    ARRAY_APPEND(float, &obj->vertices, x);
-    ARRAY_APPEND(float, &obj->vertices, y);
-    ARRAY_APPEND(float, &obj->vertices, z);
+/**
+ * Worker pool
+ *
+ * pool_run() hands out the indices [0, count) of a job to the pool's threads
+ * and to the calling thread, returning once all of them have completed.
+ */
+
+static void pool_work(pool_t *const pool) {
+    // Called with pool->lock held
+    while (pool->next < pool->count) {
+        size_t index = pool->next++;
+        pool_job_fn job = pool->job;
+        void *ctx = pool->ctx;
+
+        pthread_mutex_unlock(&pool->lock);
+        job(ctx, index);
+        pthread_mutex_lock(&pool->lock);
+
+        if (++pool->done == pool->count)
+            pthread_cond_broadcast(&pool->done_cv);
+    }
 }
 
-void obj_add_face(obj_t *const obj, size_t i, size_t j, size_t k) {
-    // obj_t stores vertex indices 1-indexed, we'll correct that here
-    ARRAY_APPEND(size_t, &obj->faces, i - 1);
-    ARRAY_APPEND(size_t, &obj->faces, j - 1);
-    ARRAY_APPEND(size_t, &obj->faces, k - 1);
+static void *pool_worker(void *arg) {
+    pool_t *pool = (pool_t *)arg;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen)
+            pthread_cond_wait(&pool->work_cv, &pool->lock);
+        if (pool->stop)
+            break;
+        seen = pool->generation;
+        pool_work(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
 }
 
-point3_t obj_get_vertex(const obj_t *const obj, size_t i, float scale) {
-    size_t pos = i * 3;
-    return (point3_t){ARRAY_GET(float, &obj->vertices, pos) * scale,
-                      ARRAY_GET(float, &obj->vertices, pos + 1) * scale,
-                      ARRAY_GET(float, &obj->vertices, pos + 2) * scale};
+/**
+ * Starts a pool of thread_count threads, counting the caller. A thread_count
+ * of 0 uses one thread per online CPU.
+ */
+int pool_init(pool_t *const pool, uint32_t thread_count) {
+    if (thread_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (uint32_t)cpus : 1;
+    }
+
+    *pool = (pool_t){0};
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cv, NULL);
+    pthread_cond_init(&pool->done_cv, NULL);
+
+    pool->threads = heap_calloc(thread_count, sizeof(pthread_t));
+    if (!pool->threads) {
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->work_cv);
+        pthread_cond_destroy(&pool->done_cv);
+        return -ENOMEM;
+    }
+
+    // The calling thread is the first worker
+    pool->thread_count = 1;
+    for (uint32_t i = 1; i < thread_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, &pool_worker, pool) != 0)
+            break;
+        pool->thread_count++;
+    }
+
+    return 0;
 }
 
-struct vec3z obj_get_face(const obj_t *const obj, size_t i) {
-    size_t pos = i * 3;
-    return (struct vec3z){ARRAY_GET(size_t, &obj->faces, pos),
-                          ARRAY_GET(size_t, &obj->faces, pos + 1),
-                          ARRAY_GET(size_t, &obj->faces, pos + 2)};
+void pool_run(pool_t *const pool, pool_job_fn job, void *ctx, size_t count) {
+    if (count == 0)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->ctx = ctx;
+    pool->count = count;
+    pool->next = 0;
+    pool->done = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cv);
+
+    pool_work(pool);
+    while (pool->done < pool->count)
+        pthread_cond_wait(&pool->done_cv, &pool->lock);
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->lock);
 }
 
-void obj_cleanup(obj_t *obj) {
-    array_cleanup(&obj->vertices);
-    array_cleanup(&obj->faces);
+void pool_cleanup(pool_t *const pool) {
+    if (!pool || !pool->threads)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (uint32_t i = 1; i < pool->thread_count; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    free(pool->threads);
+    pool->threads = NULL;
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_cv);
+    pthread_cond_destroy(&pool->done_cv);
 }
 
 void *array_get(const arraylist_t *const arr, size_t i, size_t item_size) {
@@ -668,11 +5762,24 @@ void *array_get(const arraylist_t *const arr, size_t i, size_t item_size) {
     return arr->data + i * item_size;
 }
 
+// Alignment of array items drawn from an allocator, as malloc would give
+#define ARRAY_ALIGN _Alignof(max_align_t)
+
 int array_init(arraylist_t *const array, size_t item_size, size_t capacity) {
+    return array_init_with(array, item_size, capacity, NULL);
+}
+
+/**
+ * array_init taking the items, and every later resize, from alloc.
+ */
+int array_init_with(arraylist_t *const array, size_t item_size,
+                    size_t capacity, const struct allocator *const alloc) {
     *array = (arraylist_t){
-        .data = malloc((item_size) * (capacity)),
+        .data = alloc ? mem_alloc(alloc, item_size * capacity, ARRAY_ALIGN)
+                      : heap_malloc(item_size * capacity),
         .count = 0,
-        .capacity = (capacity),
+        .capacity = capacity,
+        .alloc = alloc,
     };
 
     if (array->data == NULL) {
@@ -685,7 +5792,7 @@ int array_init(arraylist_t *const array, size_t item_size, size_t capacity) {
 void array_cleanup(arraylist_t *arr) {
     if (arr == NULL || arr->data == NULL)
         return;
-    free(arr->data);
+    mem_free(arr->alloc, arr->data);
 }
 
 int array_resize(arraylist_t *const arr, size_t size, size_t item_size) {
@@ -694,13 +5801,23 @@ int array_resize(arraylist_t *const arr, size_t size, size_t item_size) {
         return -EINVAL;
     }
 
-    arr->capacity = size;
-    arr->data = realloc(arr->data, arr->capacity * item_size);
-    if (arr->data == NULL) {
+    void *data;
+    if (arr->alloc) {
+        data = mem_alloc(arr->alloc, size * item_size, ARRAY_ALIGN);
+        if (data && arr->data) {
+            memcpy(data, arr->data, arr->count * item_size);
+            mem_free(arr->alloc, arr->data);
+        }
+    } else {
+        data = heap_realloc(arr->data, size * item_size);
+    }
+    if (data == NULL) {
         fprintf(stderr, "Failed to realloc array while resizing");
         return -ENOMEM;
     }
 
+    arr->data = data;
+    arr->capacity = size;
     return 0;
 }
 
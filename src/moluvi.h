@@ -2,6 +2,7 @@
 #define MOLUVI_H
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -33,11 +34,26 @@ struct vec3z {
 typedef struct vec2i point2_t;
 typedef struct vec3f point3_t;
 
+// Which projected winding the camera drops as back-facing. Windings are as
+// seen on the canvas, with y pointing down.
+enum cull_mode {
+    CULL_NONE, // Draw both windings
+    CULL_CW,   // Drop clockwise triangles
+    CULL_CCW,  // Drop counter-clockwise triangles
+};
+
 struct camera {
-    float focal_len; // The focal length of the camera
-    float dist;      // The distance of camera from screen
-    uint32_t width;  // The screen width
-    uint32_t height; // The screen height
+    float focal_len;     // The focal length of the camera
+    float dist;          // The distance of camera from screen
+    uint32_t width;      // The screen width
+    uint32_t height;     // The screen height
+    float near;          // Near clip distance from the camera, 0 for the default
+    enum cull_mode cull; // Back-face culling, CULL_NONE by default
+};
+
+// Affine transform: p' = m * (p.x, p.y, p.z, 1)
+struct transform {
+    float m[3][4];
 };
 
 struct rgba {
@@ -47,53 +63,323 @@ struct rgba {
     uint8_t a;
 };
 
+// Where canvases and arrays get their memory. alloc returns size bytes
+// aligned to align, a power of two, or NULL. free may be NULL for allocators
+// that release everything at once. Functions taking a const struct allocator
+// pointer use the C heap when it is NULL.
+struct allocator {
+    void *(*alloc)(void *ctx, size_t size, size_t align);
+    void (*free)(void *ctx, void *ptr);
+    void *ctx;
+};
+
+// Linear allocator carving memory out of one block, all of it released at
+// once by arena_reset. Meant for scratch that lives for a single frame.
+struct arena {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+    size_t peak; // Most bytes ever in use between two resets
+};
+
+typedef struct arena arena_t;
+
+struct arraylist {
+    void *data;
+    size_t count;
+    size_t capacity;
+    const struct allocator *alloc; // NULL for the heap
+};
+
+// TODO: Hide struct arraylist
+typedef struct arraylist arraylist_t;
+
+// Side of the square tiles the coarse depth buffer keeps a farthest depth for
+#define HIZ_TILE_SIZE 16
+
+struct depth_stats {
+    uint64_t tris_culled;   // Triangles rejected without touching any pixel
+    uint64_t pixels_culled; // Bounding box pixels skipped by tile rejection
+};
+
+struct cull_stats {
+    uint64_t backface;   // Dropped for their winding
+    uint64_t frustum;    // Entirely outside the view frustum
+    uint64_t degenerate; // Zero area once projected
+};
+
+// Largest canvas width or height. Projected vertices are held in 28.4 fixed
+// point, which must reach past every side of the canvas by the guard band.
+#define CANVAS_MAX_DIM (1 << 20)
+
+// Alignment, in bytes, of every row of a canvas_init canvas
+#define CANVAS_ALIGN 64
+
+// Canvases of at least this many bytes are mapped and marked for transparent
+// huge pages where the platform supports it. Define it as 0 to disable.
+#ifndef CANVAS_HUGE_PAGE_MIN
+#define CANVAS_HUGE_PAGE_MIN (2 << 20)
+#endif
+
+// How a depth buffer stores depths. The reversed formats store near / d for a
+// camera distance d, which falls from 1 at near towards 0 far away and is
+// interpolated exactly across the screen; nearer pixels hold larger values.
+enum depth_format {
+    DEPTH_F32,     // Camera z as a float, nearer is smaller
+    DEPTH_F32_REV, // Reversed near / d as a float
+    DEPTH_UNORM24, // Reversed near / d in 24 bits, packed in 3 bytes
+    DEPTH_UNORM16, // Reversed near / d in 16 bits
+};
+
 struct canvas {
     uint32_t width;    // Width of the canvas in px
     uint32_t height;   // Height of the canvas in px
+    uint32_t stride;   // Distance between the starts of two rows, in px
     struct rgba *data; // Pixel data, as rgba
-    float *depth;      // (Optional) Depth buffer
+    void *depth;       // (Optional) Depth buffer, with the same stride in px
+    enum depth_format depth_format;
+    float depth_near; // Distance the reversed formats store as 1
+
+    // Set for views made by canvas_view, which draw into the buffers of the
+    // canvas they were made from and own none of their own
+    struct canvas *parent;
+    uint32_t origin_x; // Position of a view within its parent
+    uint32_t origin_y;
+
+    // Coarse depth buffer (Hi-Z), allocated along with depth. A tile's entry
+    // is never nearer than any depth stored in the tile. Views leave it NULL
+    // and skip the coarse test.
+    float *depth_tiles;
+    uint32_t depth_tiles_x;         // Number of tile columns
+    struct depth_stats depth_stats; // Since the last canvas_depth_reset
+
+    struct cull_stats cull_stats; // Since the last canvas_depth_reset
+
+    // Pending fast clears of each Hi-Z sized tile, allocated by the first
+    // canvas_clear. Views use the ones of their parent.
+    struct clear_tile *clear_tiles;
+
+    // Whether each Hi-Z sized tile was drawn into since the last
+    // canvas_dirty_reset, a byte per tile, allocated by canvas_track_dirty.
+    // Views use the ones of their parent.
+    uint8_t *dirty_tiles;
+
+    arraylist_t mesh_scratch; // Transformed vertices for canvas_draw_mesh
+
+    const struct allocator *alloc; // Source of every buffer, NULL for the heap
 };
 
 // TODO: Hide struct canvas
 typedef struct canvas canvas_t;
 
+// A rectangle of pixels drawn into, see canvas_dirty_rects
+struct dirty_rect {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Canvases released for reuse, handed out again to requests of the same size
+struct canvas_pool {
+    arraylist_t idle; // canvas_t
+    const struct allocator *alloc;
+};
+
+typedef struct canvas_pool canvas_pool_t;
+
+// Glyphs are at most 8x8 pixels, each packed into 64 bits: row y in byte y,
+// pixel x of the row in bit x
+#define FONT_GLYPH_MAX 8
+
 struct font {
     uint32_t glyph_width;
     uint32_t glyph_height;
-    const char *glyphs;
+    const uint64_t *glyphs; // One per character code below 128
 };
 
 // TODO: Hide struct font
 typedef struct font font_t;
 
-struct arraylist {
-    void *data;
-    size_t count;
-    size_t capacity;
+// A string drawn at one font size, kept as the pixels its glyphs cover
+struct text_run {
+    uint64_t hash; // Of the key: the string, font and font size
+    char *str;     // Owned copy, in the same block as coverage
+    const uint64_t *glyphs;
+    uint32_t glyph_width;
+    uint32_t glyph_height;
+    uint32_t font_size;
+    uint32_t width;   // In px
+    uint32_t height;  // In px
+    uint32_t stride;  // Distance between the starts of two rows of coverage
+    uint8_t *coverage; // 0xFF where a glyph covers the pixel, 0 elsewhere
+    size_t bytes;      // Of coverage and str together
+    uint64_t last_used;
 };
 
-// TODO: Hide struct arraylist
-typedef struct arraylist arraylist_t;
+struct text_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+};
+
+// Text runs drawn recently, the least recently used dropped to stay within
+// budget bytes
+struct text_cache {
+    arraylist_t runs; // struct text_run
+    size_t budget;
+    size_t bytes;
+    uint64_t clock; // Stamps last_used
+    struct text_cache_stats stats;
+};
+
+typedef struct text_cache text_cache_t;
+
+// Alignment, in bytes, of the vertex and index arrays of an obj_t. Their
+// capacity is a multiple of OBJ_ALIGN as well, so vector loops may read whole
+// blocks past the last element.
+#define OBJ_ALIGN 64
 
 struct obj {
-    arraylist_t vertices;
-    arraylist_t faces;
+    // Vertex positions, one array per coordinate
+    float *x;
+    float *y;
+    float *z;
+    size_t vertex_count;
+    size_t vertex_capacity;
+
+    uint32_t *indices; // Three 0-based vertex indices per face
+    size_t face_count;
+    size_t face_capacity;
+
+    point3_t bounds_min; // Smallest coordinates of any vertex
+    point3_t bounds_max; // Largest coordinates of any vertex
+
+    // Set when the arrays point into a mapped mesh cache, which is read-only
+    void *mapping;
+    size_t mapping_size;
 };
 
 // TODO: Hide struct obj
 typedef struct obj obj_t;
 
+#define LOD_MAX_LEVELS 8
+
+// A mesh at decreasing levels of detail, each level about half the faces of
+// the one before
+struct lod {
+    obj_t levels[LOD_MAX_LEVELS]; // levels[0] is the full mesh
+    size_t level_count;
+};
+
+typedef struct lod lod_t;
+
+typedef void (*pool_job_fn)(void *ctx, size_t index);
+
+struct worker_pool {
+    pthread_t *threads;
+    uint32_t thread_count; // Number of threads, including the caller of run
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;
+    pthread_cond_t done_cv;
+    uint64_t generation; // Bumped for every run so workers wake up once
+    bool stop;
+
+    // Current job
+    pool_job_fn job;
+    void *ctx;
+    size_t count;
+    size_t next;
+    size_t done;
+};
+
+typedef struct worker_pool pool_t;
+
+#define BINNER_TILE_SIZE 64
+
+struct tile_binner {
+    canvas_t *canvas;
+    uint32_t tiles_x;   // Number of tile columns
+    uint32_t tiles_y;   // Number of tile rows
+    uint32_t offset_x;  // How far the first column starts left of the canvas
+    uint32_t offset_y;  // How far the first row starts above the canvas
+    arraylist_t tris;   // Queued triangles
+    arraylist_t cmds;   // Queued 2D draws of a command buffer
+    arraylist_t *bins;  // Per tile, indices into tris or cmds in submission
+                        // order
+    pool_t pool;
+};
+
+// TODO: Hide struct tile_binner
+typedef struct tile_binner binner_t;
+
+// Draw calls recorded for later, see cmd_buffer_execute
+struct cmd_buffer {
+    arraylist_t cmds; // Recorded commands in order
+    arraylist_t text; // Characters of the recorded strings
+};
+
+typedef struct cmd_buffer cmd_buffer_t;
+
+#define SWAP_MAX_BUFFERS 3
+
+// What a swap chain does with a finished frame while an older one still waits
+// to be presented
+enum swap_policy {
+    SWAP_FIFO,   // Present every frame in order, blocking the renderer
+    SWAP_LATEST, // Drop the older frame, so the renderer never waits
+};
+
+enum swap_state {
+    SWAP_FREE,       // Ready to be drawn into
+    SWAP_DRAWING,    // Handed out by swap_chain_acquire
+    SWAP_QUEUED,     // Submitted, waiting to be presented
+    SWAP_PRESENTING, // Handed out by swap_chain_next
+};
+
+struct swap_stats {
+    uint64_t presented; // Frames released after presenting
+    uint64_t dropped;   // Frames replaced by a newer one under SWAP_LATEST
+};
+
+// Presents a finished frame, on the swap chain's presentation thread
+typedef void (*swap_present_fn)(void *ctx, const canvas_t *canvas,
+                                uint64_t frame);
+
+struct swap_chain {
+    canvas_t buffers[SWAP_MAX_BUFFERS];
+    enum swap_state state[SWAP_MAX_BUFFERS];
+    uint64_t frame[SWAP_MAX_BUFFERS]; // Number of the frame in each buffer
+    uint32_t buffer_count;
+    enum swap_policy policy;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cv; // Broadcast whenever a buffer changes state
+    uint64_t next_frame;
+    bool closed;
+
+    // Started by swap_chain_present_async
+    pthread_t thread;
+    bool threaded;
+    swap_present_fn present;
+    void *present_ctx;
+
+    struct swap_stats stats;
+};
+
+typedef struct swap_chain swap_chain_t;
+
 //--------------------------------------------------------------------------------
 // API
 //--------------------------------------------------------------------------------
 
 // Math utilities
 #ifndef MIN
-#define MIN(a, b) (a) < (b) ? (a) : (b)
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
 #ifndef MAX
-#define MAX(a, b) (a) > (b) ? (a) : (b)
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
 #endif
 
 #define SUB_SATURATED(a, b) ((a) > (b) ? (a - b) : 0)
@@ -127,8 +413,22 @@ typedef struct obj obj_t;
 // Canvas creation & utils
 int canvas_init(canvas_t *const canvas, uint32_t width, uint32_t height,
                 struct rgba fill);
+int canvas_init_with(canvas_t *const canvas, uint32_t width, uint32_t height,
+                     struct rgba fill, const struct allocator *const alloc);
+int canvas_view(canvas_t *const view, canvas_t *const canvas, int64_t x,
+                int64_t y, uint32_t width, uint32_t height);
 int canvas_use_depth(canvas_t *const canvas);
+int canvas_use_depth_format(canvas_t *const canvas, enum depth_format format,
+                            float near);
 int canvas_depth_reset(canvas_t *const canvas);
+int canvas_clear(canvas_t *const canvas, struct rgba color);
+void canvas_resolve(canvas_t *const canvas);
+int canvas_track_dirty(canvas_t *const canvas);
+void canvas_dirty_reset(canvas_t *const canvas);
+bool canvas_tile_dirty(const canvas_t *const canvas, uint32_t tx, uint32_t ty);
+int canvas_dirty_rects(const canvas_t *const canvas, arraylist_t *const rects);
+struct depth_stats canvas_depth_stats(const canvas_t *const canvas);
+struct cull_stats canvas_cull_stats(const canvas_t *const canvas);
 void canvas_cleanup(canvas_t *const canvas);
 int canvas_get_px(const canvas_t *const canvas, uint32_t x, uint32_t y,
                   struct rgba *px);
@@ -136,6 +436,12 @@ int canvas_set_px(canvas_t *const canvas, uint32_t x, uint32_t y,
                   struct rgba color);
 int canvas_blend_px(canvas_t *const canvas, uint32_t x, uint32_t y,
                     struct rgba color);
+int canvas_set_span(canvas_t *const canvas, int64_t x, int64_t y, int64_t len,
+                    struct rgba color);
+int canvas_blend_span(canvas_t *const canvas, int64_t x, int64_t y,
+                      int64_t len, struct rgba color);
+int canvas_blend_canvas(canvas_t *const canvas, const canvas_t *const layer,
+                        int64_t x, int64_t y);
 
 // 3D utilities
 void point3_rotate(point3_t *point, point3_t center, float theta);
@@ -143,12 +449,73 @@ point2_t point3_proj(point3_t point, struct camera cam);
 float scale_z(float val, float z, struct camera cam);
 int canvas_proj_tri(canvas_t *const canvas, point3_t *const vertices,
                     struct camera cam);
+struct transform transform_model(point3_t origin, float scale, float theta);
+point3_t transform_apply(const struct transform *const t, point3_t p);
+int canvas_draw_mesh(canvas_t *const canvas, const obj_t *const obj,
+                     const struct transform *const model, struct camera cam);
+size_t lod_select(const lod_t *const lod, const struct transform *const model,
+                  struct camera cam);
+int canvas_draw_lod(canvas_t *const canvas, const lod_t *const lod,
+                    const struct transform *const model, struct camera cam);
+
+// Tile-binned, multithreaded 3D rasterization
+int binner_init(binner_t *const binner, canvas_t *const canvas,
+                uint32_t thread_count);
+int binner_proj_tri(binner_t *const binner, point3_t *const vertices,
+                    struct camera cam);
+int binner_draw_mesh(binner_t *const binner, const obj_t *const obj,
+                     const struct transform *const model, struct camera cam);
+int binner_draw_lod(binner_t *const binner, const lod_t *const lod,
+                    const struct transform *const model, struct camera cam);
+int binner_set_canvas(binner_t *const binner, canvas_t *const canvas);
+void binner_flush(binner_t *const binner);
+void binner_cleanup(binner_t *const binner);
+
+// Command buffers
+int cmd_buffer_init(cmd_buffer_t *const cmds);
+void cmd_buffer_reset(cmd_buffer_t *const cmds);
+void cmd_buffer_cleanup(cmd_buffer_t *const cmds);
+int cmd_fill(cmd_buffer_t *const cmds, struct rgba color);
+int cmd_fill_rect(cmd_buffer_t *const cmds, uint32_t x, uint32_t y,
+                  uint32_t width, uint32_t height, struct rgba color);
+int cmd_fill_circle(cmd_buffer_t *const cmds, int64_t center_x,
+                    int64_t center_y, uint32_t radius, struct rgba color);
+int cmd_fill_circle_aa(cmd_buffer_t *const cmds, int64_t center_x,
+                       int64_t center_y, uint32_t radius, struct rgba color);
+int cmd_fill_tri(cmd_buffer_t *const cmds, int64_t x0, int64_t y0, int64_t x1,
+                 int64_t y1, int64_t x2, int64_t y2, struct rgba color);
+int cmd_fill_quad(cmd_buffer_t *const cmds, point2_t p1, point2_t p2,
+                  point2_t p3, point2_t p4, struct rgba color);
+int cmd_draw_line(cmd_buffer_t *const cmds, uint32_t x0, uint32_t y0,
+                  uint32_t x1, uint32_t y1, struct rgba color,
+                  uint32_t thiccness);
+int cmd_write_string(cmd_buffer_t *const cmds, const char *str, uint32_t x,
+                     uint32_t y, font_t font, uint32_t font_size,
+                     struct rgba color);
+int cmd_draw_mesh(cmd_buffer_t *const cmds, const obj_t *const obj,
+                  const struct transform *const model, struct camera cam);
+int cmd_buffer_execute(const cmd_buffer_t *const cmds,
+                       binner_t *const binner);
+
+// Swap chains
+int swap_chain_init(swap_chain_t *const chain, uint32_t width, uint32_t height,
+                    uint32_t buffer_count, enum swap_policy policy);
+canvas_t *swap_chain_acquire(swap_chain_t *const chain, uint64_t *frame);
+void swap_chain_submit(swap_chain_t *const chain, canvas_t *const canvas);
+canvas_t *swap_chain_next(swap_chain_t *const chain, uint64_t *frame);
+void swap_chain_release(swap_chain_t *const chain, canvas_t *const canvas);
+int swap_chain_present_async(swap_chain_t *const chain, swap_present_fn present,
+                             void *ctx);
+void swap_chain_close(swap_chain_t *const chain);
+struct swap_stats swap_chain_stats(swap_chain_t *const chain);
+void swap_chain_cleanup(swap_chain_t *const chain);
 
 // Color functions
 uint32_t rgba_to_hex(struct rgba color);
 struct rgba hex_to_rgba(uint32_t hex);
 struct rgba rgba_convert_grayscale(struct rgba color);
 struct rgba rgba_alpha_blend(struct rgba fg, struct rgba bg);
+void rgba_blend_span(struct rgba *dst, const struct rgba *src, size_t n);
 bool rgba_eql(struct rgba c1, struct rgba c2);
 struct rgba rgba_diff_blend(struct rgba c1, struct rgba c2);
 
@@ -158,6 +525,9 @@ int canvas_fill_rect(canvas_t *const canvas, uint32_t x, uint32_t y,
                      uint32_t width, uint32_t height, struct rgba color);
 int canvas_fill_circle(canvas_t *const canvas, int64_t center_x,
                        int64_t center_y, uint32_t radius, struct rgba color);
+int canvas_fill_circle_aa(canvas_t *const canvas, int64_t center_x,
+                          int64_t center_y, uint32_t radius,
+                          struct rgba color);
 int canvas_fill_tri(canvas_t *const canvas, int64_t x0, int64_t y0, int64_t x1,
                     int64_t y1, int64_t x2, int64_t y2, struct rgba color);
 void canvas_fill_triInterpolated(canvas_t *const canvas, point2_t v1,
@@ -174,32 +544,84 @@ void canvas_draw_char(canvas_t *const canvas, char c, uint32_t x, uint32_t y,
 void canvas_write_string(canvas_t *const canvas, const char *str, uint32_t x,
                          uint32_t y, font_t font, uint32_t font_size,
                          struct rgba color);
+int canvas_write_string_cached(canvas_t *const canvas,
+                               text_cache_t *const cache, const char *str,
+                               uint32_t x, uint32_t y, font_t font,
+                               uint32_t font_size, struct rgba color);
+int text_cache_init(text_cache_t *const cache, size_t budget);
+struct text_cache_stats text_cache_stats(const text_cache_t *const cache);
+void text_cache_cleanup(text_cache_t *const cache);
 
 // Canvas rendering
 void canvas_render_ppm(const canvas_t *const canvas, const char *filename);
+int canvas_write_dirty_ppm(const canvas_t *const canvas, FILE *file,
+                           arraylist_t *const rects);
 canvas_t canvas_load_ppm(const char *filename);
 
 // font_t utils
-const char *font_get_glyph(font_t font, char c);
+uint64_t font_get_glyph(font_t font, char c);
 
 // obj_t utils
 int obj_init(obj_t *const obj);
 int obj_load(obj_t *const obj, const char *filename);
 size_t obj_vertex_count(const obj_t *const obj);
 size_t obj_face_count(const obj_t *const obj);
-void obj_add_vertex(obj_t *const obj, float x, float y, float z);
-void obj_add_face(obj_t *const obj, size_t i, size_t j, size_t k);
+int obj_add_vertex(obj_t *const obj, float x, float y, float z);
+int obj_add_face(obj_t *const obj, size_t i, size_t j, size_t k);
 point3_t obj_get_vertex(const obj_t *const obj, size_t i, float scale);
 struct vec3z obj_get_face(const obj_t *const obj, size_t i);
 void obj_cleanup(obj_t *obj);
+int obj_optimize(obj_t *const obj);
+float obj_acmr(const obj_t *const obj, uint32_t cache_size);
+int obj_simplify(const obj_t *const obj, obj_t *const out,
+                 size_t target_faces);
+int lod_build(lod_t *const lod, obj_t *const obj, size_t min_faces);
+void lod_cleanup(lod_t *const lod);
+
+// Binary mesh caches
+int obj_write_cache(const obj_t *const obj, const char *cache_path,
+                    const char *source_path);
+int obj_map_cache(obj_t *const obj, const char *cache_path,
+                  const char *source_path);
+int obj_load_cached(obj_t *const obj, const char *filename);
+
+// Unchecked accessors for hot loops. Indices must be in range.
+static inline point3_t obj_vertex(const obj_t *const obj, uint32_t i) {
+    return (point3_t){obj->x[i], obj->y[i], obj->z[i]};
+}
+
+static inline const uint32_t *obj_face(const obj_t *const obj, size_t i) {
+    return &obj->indices[i * 3];
+}
 
 // Misc utilities
 float lerpf(float t, float a, float b);
 double lerpd(double t, double a, double b);
 
+// Memory
+uint64_t heap_alloc_count(void);
+int arena_init(arena_t *const arena, size_t size);
+void *arena_alloc(arena_t *const arena, size_t size, size_t align);
+void arena_reset(arena_t *const arena);
+void arena_cleanup(arena_t *const arena);
+struct allocator arena_allocator(arena_t *const arena);
+int canvas_pool_init(canvas_pool_t *const pool,
+                     const struct allocator *const alloc);
+int canvas_pool_acquire(canvas_pool_t *const pool, canvas_t *const canvas,
+                        uint32_t width, uint32_t height, struct rgba fill);
+int canvas_pool_release(canvas_pool_t *const pool, canvas_t *const canvas);
+void canvas_pool_cleanup(canvas_pool_t *const pool);
+
+// Worker pool
+int pool_init(pool_t *const pool, uint32_t thread_count);
+void pool_run(pool_t *const pool, pool_job_fn job, void *ctx, size_t count);
+void pool_cleanup(pool_t *const pool);
+
 // Arrays
 void *array_get(const arraylist_t *const arr, size_t i, size_t item_size);
 int array_init(arraylist_t *const array, size_t item_size, size_t capacity);
+int array_init_with(arraylist_t *const array, size_t item_size,
+                    size_t capacity, const struct allocator *const alloc);
 int array_resize(arraylist_t *const arr, size_t size, size_t item_size);
 void array_cleanup(arraylist_t *arr);
 
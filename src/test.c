@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #define NOB_IMPLEMENTATION
 #include "../nob.h"
@@ -18,6 +19,9 @@
 
 #define COLOR_DIFF COLOR_RED
 
+// Test, diff and layer canvases are reused from case to case
+static canvas_pool_t test_pool;
+
 enum ansi_esc {
     ANSI_RESET = 0,
     ANSI_BOLD = 1,
@@ -62,7 +66,8 @@ bool canvas_calc_diff(const canvas_t *const canvas_A,
                   enum diff_mode diff_mode) {
     uint32_t diff_width = MAX(canvas_A->width, canvas_B->width);
     uint32_t diff_height = MAX(canvas_A->height, canvas_B->height);
-    canvas_init(canvas_diff, diff_width, diff_height, COLOR_BLACK);
+    canvas_pool_acquire(&test_pool, canvas_diff, diff_width, diff_height,
+                        COLOR_BLACK);
 
     bool diff = false;
     for (uint32_t x = 0; x < diff_width; x++) {
@@ -122,9 +127,23 @@ void canvas_test_diff(const canvas_t *const canvas, const char *ref_file,
     }
 
     canvas_cleanup(&ref_canvas);
-    canvas_cleanup(&canvas_diff);
+    canvas_pool_release(&test_pool, &canvas_diff);
 }
 
+/**
+ * Reports a check the reference image cannot show, such as a count, the way
+ * a failed comparison is reported.
+ */
+void test_expect(bool ok, const char *what, const char *file, int line) {
+    if (ok)
+        return;
+    ansi_esc_stdout(ANSI_RED);
+    printf("❌ CHECK %s FAILED! (%s:%d)\n", what, file, line);
+    ansi_esc_stdout(ANSI_BRIGHT_BLACK);
+}
+
+#define EXPECT(cond) test_expect((cond), #cond, __FILE__, __LINE__)
+
 void test_case(example_fn fn, const char *ref_file, enum subcommand cmd,
               enum diff_mode diff_mode) {
     printf("Running test case %s\n", ref_file);
@@ -133,7 +152,7 @@ void test_case(example_fn fn, const char *ref_file, enum subcommand cmd,
     ansi_esc_stdout(ANSI_BRIGHT_BLACK);
 
     canvas_t canvas;
-    canvas_init(&canvas, WIDTH, HEIGHT, COLOR_WHITE);
+    canvas_pool_acquire(&test_pool, &canvas, WIDTH, HEIGHT, COLOR_WHITE);
     fn(&canvas);
 
     if (cmd == CMD_RUN) {
@@ -143,7 +162,7 @@ void test_case(example_fn fn, const char *ref_file, enum subcommand cmd,
         canvas_render_ppm(&canvas, ref_file);
     }
 
-    canvas_cleanup(&canvas);
+    canvas_pool_release(&test_pool, &canvas);
 
     printf("\n");
 }
@@ -218,6 +237,1181 @@ void triangle_example(canvas_t *const canvas) {
                         font_mojangles, 2, COLOR_BLACK);
 }
 
+// Triangles reaching far into the guard band, too large for 32-bit edge
+// functions
+void wide_triangle_example(canvas_t *const canvas) {
+    canvas_fill_tri(canvas, -3000, -1000, 3000, 200, 300, 2400,
+                    C(0xFF3366AA));
+    canvas_fill_triInterpolated(canvas, (point2_t){-3900, 470},
+                                (point2_t){4500, 10}, (point2_t){320, 4000});
+    canvas_fill_triInterpolated(canvas, (point2_t){100, 100},
+                                (point2_t){2600, 300}, (point2_t){200, 400});
+}
+
+void circles_example(canvas_t *const canvas) {
+    for (uint32_t i = 0; i < 8; i++) {
+        uint32_t r = 2 + i * 4;
+        int64_t x = 20 + i * 75;
+        canvas_fill_circle(canvas, x, HEIGHT / 4, r, C(0xFFB04010));
+        canvas_fill_circle_aa(canvas, x, HEIGHT / 2, r, C(0xFFB04010));
+        canvas_fill_circle_aa(canvas, x, 3 * HEIGHT / 4, r, C(0x802020E0));
+    }
+
+    // Clipped at the corners
+    canvas_fill_circle(canvas, -10, -10, 60, COLOR_BLACK);
+    canvas_fill_circle_aa(canvas, WIDTH + 10, HEIGHT + 10, 60, COLOR_BLACK);
+}
+
+void layers_example(canvas_t *const canvas) {
+    canvas_fill_rect(canvas, 40, 40, WIDTH - 80, HEIGHT - 80, C(0xFF3C8CF0));
+
+    // A layer whose alpha ramps from transparent to opaque left to right
+    canvas_t layer;
+    canvas_pool_acquire(&test_pool, &layer, 256, 160, COLOR_WHITE);
+    for (uint32_t y = 0; y < layer.height; y++) {
+        for (uint32_t x = 0; x < layer.width; x++) {
+            struct rgba color = {(uint8_t)x, (uint8_t)(y * 3 / 2),
+                                 (uint8_t)(255 - x), (uint8_t)x};
+            canvas_set_px(&layer, x, y, color);
+        }
+    }
+
+    canvas_blend_canvas(canvas, &layer, 100, 100);
+    canvas_blend_canvas(canvas, &layer, 200, 180);
+    canvas_blend_canvas(canvas, &layer, -60, HEIGHT - 100);
+    canvas_blend_canvas(canvas, &layer, WIDTH - 128, -40);
+    canvas_pool_release(&test_pool, &layer);
+}
+
+#define MESH_SCALE 35
+#define MESH_ANGLE 0.7
+
+static struct camera mesh_cam = {
+    .dist = 1000,
+    .focal_len = 1000,
+    .width = WIDTH,
+    .height = HEIGHT,
+};
+
+static void mesh_face_vertices(const obj_t *const obj, size_t i, float scale,
+                               point3_t vertices[3]) {
+    point3_t center = {0, 0, 0};
+    struct vec3z face = obj_get_face(obj, i);
+    vertices[0] = obj_get_vertex(obj, face.x, scale);
+    vertices[1] = obj_get_vertex(obj, face.y, scale);
+    vertices[2] = obj_get_vertex(obj, face.z, scale);
+    for (int j = 0; j < 3; j++)
+        point3_rotate(&vertices[j], center, MESH_ANGLE);
+}
+
+void mesh_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    for (size_t i = 0; i < obj_face_count(&cow); i++) {
+        point3_t vertices[3];
+        mesh_face_vertices(&cow, i, MESH_SCALE, vertices);
+        canvas_proj_tri(canvas, vertices, mesh_cam);
+    }
+    obj_cleanup(&cow);
+}
+
+// mesh_example, after loading a triangle whose coordinates have zero
+// mantissas with huge exponents and exponents past the float range. Each must
+// parse to what strtof gives.
+void obj_float_example(canvas_t *const canvas) {
+    static const char *coords[9] = {
+        "0e400", "-0e-999", "1e-400",
+        "1e400", "-1e40",   ".5e1",
+        "1e-46", "123456789012345678901234e-10", "-00.0e99",
+    };
+    const char *path = "build/floats.obj";
+    nob_mkdir_if_not_exists("build");
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        EXPECT(!"cannot write build/floats.obj");
+        return;
+    }
+    for (int i = 0; i < 3; i++)
+        fprintf(file, "v %s %s %s\n", coords[3 * i], coords[3 * i + 1],
+                coords[3 * i + 2]);
+    fprintf(file, "f 1 2 3\n");
+    fclose(file);
+
+    obj_t obj;
+    int ret = obj_load(&obj, path);
+    EXPECT(ret == 0);
+    if (ret == 0) {
+        for (size_t i = 0; i < 9; i++) {
+            point3_t v = obj_get_vertex(&obj, i / 3, 1);
+            float got = i % 3 == 0 ? v.x : i % 3 == 1 ? v.y : v.z;
+            float want = strtof(coords[i], NULL);
+            EXPECT(memcmp(&got, &want, sizeof(got)) == 0);
+        }
+        obj_cleanup(&obj);
+    }
+    remove(path);
+    mesh_example(canvas);
+}
+
+// mesh_example on a canvas taken from the pool after one with a 16-bit depth
+// buffer, a pending clear and dirty tracking was released into it. None of
+// that may carry over.
+void pool_reuse_example(canvas_t *const canvas) {
+    canvas_t used;
+    canvas_pool_acquire(&test_pool, &used, WIDTH, HEIGHT, COLOR_WHITE);
+    canvas_use_depth_format(&used, DEPTH_UNORM16, 100);
+    canvas_track_dirty(&used);
+    canvas_clear(&used, COLOR_RED);
+    EXPECT(canvas_pool_release(&test_pool, &used) == 0);
+
+    canvas_t reused;
+    canvas_pool_acquire(&test_pool, &reused, WIDTH, HEIGHT, COLOR_WHITE);
+    EXPECT(!reused.depth && reused.depth_format == DEPTH_F32);
+    EXPECT(!reused.clear_tiles && !reused.dirty_tiles);
+    mesh_example(&reused);
+    canvas_blend_canvas(canvas, &reused, 0, 0);
+    canvas_pool_release(&test_pool, &reused);
+}
+
+// Must match mesh_example bit for bit
+void mesh_binned_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    binner_t binner;
+    binner_init(&binner, canvas, 4);
+    for (size_t i = 0; i < obj_face_count(&cow); i++) {
+        point3_t vertices[3];
+        mesh_face_vertices(&cow, i, MESH_SCALE, vertices);
+        binner_proj_tri(&binner, vertices, mesh_cam);
+    }
+    binner_flush(&binner);
+    binner_cleanup(&binner);
+    obj_cleanup(&cow);
+}
+
+// The cow of mesh_example through canvas_draw_mesh. The folded transform
+// rounds differently from point3_rotate, so it has its own reference.
+void mesh_draw_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, MESH_SCALE, MESH_ANGLE);
+    canvas_draw_mesh(canvas, &cow, &model, mesh_cam);
+    obj_cleanup(&cow);
+}
+
+// Must match mesh_draw_example bit for bit
+void mesh_draw_binned_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    binner_t binner;
+    binner_init(&binner, canvas, 4);
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, MESH_SCALE, MESH_ANGLE);
+    binner_draw_mesh(&binner, &cow, &model, mesh_cam);
+    binner_flush(&binner);
+    binner_cleanup(&binner);
+    obj_cleanup(&cow);
+}
+
+#define MESH_CACHE_PATH "vendor/cow.obj.mesh"
+
+// mesh_draw_example with the cow loaded through its mesh cache, which must
+// have been mapped rather than parsed when mapped is set.
+static void mesh_cache_draw(canvas_t *const canvas, bool mapped) {
+    obj_t cow;
+    int ret = obj_load_cached(&cow, "vendor/cow.obj");
+    EXPECT(ret == 0);
+    if (ret < 0)
+        return;
+    EXPECT((cow.mapping != NULL) == mapped);
+    canvas_use_depth(canvas);
+
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, MESH_SCALE, MESH_ANGLE);
+    canvas_draw_mesh(canvas, &cow, &model, mesh_cam);
+    obj_cleanup(&cow);
+}
+
+// Starts without a cache, so the cow is parsed and the cache written
+void mesh_cache_example(canvas_t *const canvas) {
+    remove(MESH_CACHE_PATH);
+    mesh_cache_draw(canvas, false);
+}
+
+// Maps the cache mesh_cache_example wrote, then removes it
+void mesh_cache_mapped_example(canvas_t *const canvas) {
+    mesh_cache_draw(canvas, true);
+    remove(MESH_CACHE_PATH);
+}
+
+#define MESH_CLIP_SCALE 60
+
+// Close enough that the cow crosses the near plane and the canvas edges
+static struct camera mesh_clip_cam = {
+    .dist = 160,
+    .focal_len = 130,
+    .width = WIDTH,
+    .height = HEIGHT,
+};
+
+void mesh_clip_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    for (size_t i = 0; i < obj_face_count(&cow); i++) {
+        point3_t vertices[3];
+        mesh_face_vertices(&cow, i, MESH_CLIP_SCALE, vertices);
+        canvas_proj_tri(canvas, vertices, mesh_clip_cam);
+    }
+    obj_cleanup(&cow);
+}
+
+// Must match mesh_clip_example bit for bit
+void mesh_clip_binned_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    binner_t binner;
+    binner_init(&binner, canvas, 4);
+    for (size_t i = 0; i < obj_face_count(&cow); i++) {
+        point3_t vertices[3];
+        mesh_face_vertices(&cow, i, MESH_CLIP_SCALE, vertices);
+        binner_proj_tri(&binner, vertices, mesh_clip_cam);
+    }
+    binner_flush(&binner);
+    binner_cleanup(&binner);
+    obj_cleanup(&cow);
+}
+
+// The clip camera, dropping back faces and whatever is outside the frustum
+static struct camera mesh_cull_cam = {
+    .dist = 160,
+    .focal_len = 130,
+    .width = WIDTH,
+    .height = HEIGHT,
+    .cull = CULL_CCW,
+};
+
+void mesh_cull_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    for (size_t i = 0; i < obj_face_count(&cow); i++) {
+        point3_t vertices[3];
+        mesh_face_vertices(&cow, i, MESH_CLIP_SCALE, vertices);
+        canvas_proj_tri(canvas, vertices, mesh_cull_cam);
+    }
+    obj_cleanup(&cow);
+}
+
+// Must match mesh_cull_example bit for bit
+void mesh_cull_binned_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    binner_t binner;
+    binner_init(&binner, canvas, 4);
+    for (size_t i = 0; i < obj_face_count(&cow); i++) {
+        point3_t vertices[3];
+        mesh_face_vertices(&cow, i, MESH_CLIP_SCALE, vertices);
+        binner_proj_tri(&binner, vertices, mesh_cull_cam);
+    }
+    binner_flush(&binner);
+    binner_cleanup(&binner);
+    obj_cleanup(&cow);
+}
+
+// The cull camera through canvas_draw_mesh
+void mesh_draw_cull_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, MESH_CLIP_SCALE, MESH_ANGLE);
+    canvas_draw_mesh(canvas, &cow, &model, mesh_cull_cam);
+    obj_cleanup(&cow);
+}
+
+// Must match mesh_draw_cull_example bit for bit. Without culling, faces
+// folding over the silhouette tie in depth along their shared edges and the
+// first one drawn wins, so reordering them can move a few pixels there.
+void mesh_optimize_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    if (obj_optimize(&cow) < 0) {
+        obj_cleanup(&cow);
+        return;
+    }
+    canvas_use_depth(canvas);
+
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, MESH_CLIP_SCALE, MESH_ANGLE);
+    canvas_draw_mesh(canvas, &cow, &model, mesh_cull_cam);
+    obj_cleanup(&cow);
+}
+
+#define LOD_COWS 5
+#define LOD_SCALE 25
+
+static struct camera lod_cam = {
+    .dist = 1000,
+    .focal_len = 1000,
+    .width = WIDTH,
+    .height = HEIGHT,
+    .cull = CULL_CCW,
+};
+
+// Screen x and depth of each cow, getting smaller to the right
+static const float lod_cow_x[LOD_COWS] = {140, 360, 480, 545, 585};
+static const float lod_cow_z[LOD_COWS] = {0, 1000, 3000, 7000, 15000};
+
+static struct transform lod_cow_model(int i) {
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, LOD_SCALE, MESH_ANGLE);
+    float depth = lod_cow_z[i] + lod_cam.dist;
+    model.m[0][3] += (lod_cow_x[i] - WIDTH / 2.f) * depth / lod_cam.focal_len;
+    model.m[2][3] += lod_cow_z[i];
+    return model;
+}
+
+// Cows further away drawn at lower levels of detail
+void lod_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    lod_t lod;
+    if (lod_build(&lod, &cow, 64) < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    // lod_build leaves cow zeroed, which must still take vertices and faces
+    for (int i = 0; i < 20; i++)
+        EXPECT(obj_add_vertex(&cow, i, -i, 1) == 0);
+    EXPECT(obj_add_face(&cow, 1, 2, 3) == 0);
+    EXPECT(cow.bounds_min.x == 0 && cow.bounds_max.y == 0 &&
+           cow.bounds_min.z == 1);
+    obj_cleanup(&cow);
+
+    for (int i = 0; i < LOD_COWS; i++) {
+        struct transform model = lod_cow_model(i);
+        canvas_draw_lod(canvas, &lod, &model, lod_cam);
+    }
+    lod_cleanup(&lod);
+}
+
+// Must match lod_example bit for bit
+void lod_binned_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    lod_t lod;
+    if (lod_build(&lod, &cow, 64) < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    binner_t binner;
+    binner_init(&binner, canvas, 4);
+    for (int i = 0; i < LOD_COWS; i++) {
+        struct transform model = lod_cow_model(i);
+        binner_draw_lod(&binner, &lod, &model, lod_cam);
+    }
+    binner_flush(&binner);
+    binner_cleanup(&binner);
+    lod_cleanup(&lod);
+}
+
+#define VIEW_GAP 6
+#define VIEW_WIDTH ((WIDTH - VIEW_GAP) / 2)
+
+static const float view_angle[2] = {MESH_ANGLE, MESH_ANGLE + 2.4f};
+static const uint32_t view_bg[2] = {0xFFF0E0C8, 0xFFC8E0F0};
+
+/**
+ * Makes view the left or right half of a split screen, with a white gap
+ * between them. The halves start and end off the 16 pixel rows of the canvas.
+ */
+static void view_split(canvas_t *const view, canvas_t *const canvas, int i,
+                       struct camera *cam) {
+    canvas_view(view, canvas, i * (VIEW_WIDTH + VIEW_GAP), 0, VIEW_WIDTH,
+                HEIGHT);
+    canvas_fill(view, C(view_bg[i]));
+    // Clipped by the view, not the canvas
+    canvas_fill_circle(view, VIEW_WIDTH, HEIGHT / 2, 60, C(0xC03C8CF0));
+    canvas_write_string(view, i == 0 ? "LEFT" : "RIGHT", 10, HEIGHT - 20,
+                        font_mojangles, 2, COLOR_BLACK);
+    *cam = (struct camera){.dist = 1000,
+                           .focal_len = 1000,
+                           .width = view->width,
+                           .height = view->height,
+                           .cull = CULL_CCW};
+}
+
+// The cow of mesh_draw_example with a reversed depth buffer in format. Only
+// 16 bits lose enough precision to change a pixel.
+static void depth_format_draw(canvas_t *const canvas, enum depth_format format,
+                              bool binned) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth_format(canvas, format, 100);
+
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, MESH_SCALE, MESH_ANGLE);
+    if (binned) {
+        binner_t binner;
+        binner_init(&binner, canvas, 4);
+        binner_draw_mesh(&binner, &cow, &model, mesh_cam);
+        binner_flush(&binner);
+        binner_cleanup(&binner);
+    } else {
+        canvas_draw_mesh(canvas, &cow, &model, mesh_cam);
+    }
+    obj_cleanup(&cow);
+}
+
+void depth_f32_rev_example(canvas_t *const canvas) {
+    depth_format_draw(canvas, DEPTH_F32_REV, false);
+}
+
+void depth_unorm24_example(canvas_t *const canvas) {
+    depth_format_draw(canvas, DEPTH_UNORM24, false);
+}
+
+void depth_unorm16_example(canvas_t *const canvas) {
+    depth_format_draw(canvas, DEPTH_UNORM16, false);
+}
+
+// Must match depth_unorm16_example bit for bit
+void depth_unorm16_binned_example(canvas_t *const canvas) {
+    depth_format_draw(canvas, DEPTH_UNORM16, true);
+}
+
+// A triangle 50 units from the camera, nearer than the depth_near of 100 the
+// reversed formats get, drawn before the cow of mesh_draw_example. The cow
+// behind it must not show through in any format.
+static void depth_near_draw(canvas_t *const canvas, enum depth_format format) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth_format(canvas, format, 100);
+
+    point3_t near_tri[3] = {{-8, -6, -950}, {8, -6, -950}, {0, 8, -950}};
+    EXPECT(canvas_proj_tri(canvas, near_tri, mesh_cam) == 0);
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, MESH_SCALE, MESH_ANGLE);
+    canvas_draw_mesh(canvas, &cow, &model, mesh_cam);
+    obj_cleanup(&cow);
+}
+
+void depth_near_example(canvas_t *const canvas) {
+    depth_near_draw(canvas, DEPTH_F32);
+}
+
+void depth_near_f32_rev_example(canvas_t *const canvas) {
+    depth_near_draw(canvas, DEPTH_F32_REV);
+}
+
+void depth_near_unorm24_example(canvas_t *const canvas) {
+    depth_near_draw(canvas, DEPTH_UNORM24);
+}
+
+static void clear_frame(canvas_t *const canvas, struct rgba bg, bool fast) {
+    if (fast) {
+        canvas_clear(canvas, bg);
+        return;
+    }
+    canvas_fill(canvas, bg);
+    canvas_depth_reset(canvas);
+}
+
+static void clear_draw_cow(canvas_t *const canvas, const obj_t *const cow,
+                           float angle, bool binned) {
+    struct camera cam = {.dist = 1000,
+                         .focal_len = 1000,
+                         .width = canvas->width,
+                         .height = canvas->height,
+                         .cull = CULL_CCW};
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, MESH_SCALE, angle);
+    if (!binned) {
+        canvas_draw_mesh(canvas, cow, &model, cam);
+        return;
+    }
+    binner_t binner;
+    binner_init(&binner, canvas, 4);
+    binner_draw_mesh(&binner, cow, &model, cam);
+    binner_flush(&binner);
+    binner_cleanup(&binner);
+}
+
+#define CLEAR_VIEW_X 405
+#define CLEAR_VIEW_Y 283
+#define CLEAR_VIEW_WIDTH 201
+#define CLEAR_VIEW_HEIGHT 157
+
+// Clears an inset view off the tile grid and draws the cow into it
+static void clear_view_frame(canvas_t *const canvas, const obj_t *const cow,
+                             bool fast, bool binned) {
+    canvas_t view;
+    canvas_view(&view, canvas, CLEAR_VIEW_X, CLEAR_VIEW_Y, CLEAR_VIEW_WIDTH,
+                CLEAR_VIEW_HEIGHT);
+    clear_frame(&view, C(0xFFE0E0E0), fast);
+    clear_draw_cow(&view, cow, MESH_ANGLE, binned);
+    canvas_cleanup(&view);
+}
+
+/**
+ * Three presented frames of a turning cow and then an inset view off the tile
+ * grid, each cleared eagerly or with canvas_clear. The last frame keeps the
+ * background of the one before, so only the tiles that frame drew to have to
+ * be cleared again.
+ */
+static void clear_frames(canvas_t *const canvas, bool fast, bool binned) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    for (int frame = 0; frame < 3; frame++) {
+        clear_frame(canvas, C(frame == 0 ? 0xFF402010 : 0xFF103020), fast);
+        clear_draw_cow(canvas, &cow, MESH_ANGLE + frame, binned);
+        canvas_fill_rect(canvas, 20 + 40 * frame, 20, 30, 30, C(0xC0F0C040));
+        canvas_resolve(canvas);
+    }
+
+    clear_view_frame(canvas, &cow, fast, binned);
+    obj_cleanup(&cow);
+}
+
+void clear_example(canvas_t *const canvas) {
+    clear_frames(canvas, false, false);
+}
+
+// Must match clear_example bit for bit
+void clear_fast_example(canvas_t *const canvas) {
+    clear_frames(canvas, true, false);
+}
+
+// Must match clear_example bit for bit
+void clear_fast_binned_example(canvas_t *const canvas) {
+    clear_frames(canvas, true, true);
+}
+
+/**
+ * clear_fast_binned_example with the view frame drawn again and again, each
+ * time with the same pixels as the first. Threads drawing neighbouring binner
+ * tiles of the view must not resolve the same clear tile of the canvas.
+ */
+void clear_view_repeat_example(canvas_t *const canvas) {
+    clear_frames(canvas, true, true);
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+
+    canvas_resolve(canvas);
+    struct rgba *first = malloc(CLEAR_VIEW_WIDTH * CLEAR_VIEW_HEIGHT *
+                                sizeof(struct rgba));
+    if (!first) {
+        obj_cleanup(&cow);
+        return;
+    }
+    for (uint32_t y = 0; y < CLEAR_VIEW_HEIGHT; y++)
+        for (uint32_t x = 0; x < CLEAR_VIEW_WIDTH; x++)
+            canvas_get_px(canvas, CLEAR_VIEW_X + x, CLEAR_VIEW_Y + y,
+                          &first[y * CLEAR_VIEW_WIDTH + x]);
+
+    size_t differing = 0;
+    for (int frame = 0; frame < 50; frame++) {
+        clear_view_frame(canvas, &cow, true, true);
+        canvas_resolve(canvas);
+        for (uint32_t y = 0; y < CLEAR_VIEW_HEIGHT; y++) {
+            for (uint32_t x = 0; x < CLEAR_VIEW_WIDTH; x++) {
+                struct rgba px;
+                canvas_get_px(canvas, CLEAR_VIEW_X + x, CLEAR_VIEW_Y + y, &px);
+                differing += !rgba_eql(px, first[y * CLEAR_VIEW_WIDTH + x]);
+            }
+        }
+    }
+    EXPECT(differing == 0);
+    free(first);
+    obj_cleanup(&cow);
+}
+
+/**
+ * clear_fast_binned_example, after which the view frame is drawn again
+ * directly and then binned with dirty tracking. Both must leave the same tiles
+ * dirty.
+ */
+void clear_view_dirty_example(canvas_t *const canvas) {
+    clear_frames(canvas, true, true);
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+
+    uint32_t tiles_x = (WIDTH + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE;
+    uint32_t tiles_y = (HEIGHT + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE;
+    bool *direct = calloc((size_t)tiles_x * tiles_y, sizeof(bool));
+    if (!direct || canvas_track_dirty(canvas) < 0) {
+        EXPECT(!"cannot track dirty tiles");
+        free(direct);
+        obj_cleanup(&cow);
+        return;
+    }
+    canvas_dirty_reset(canvas);
+    clear_view_frame(canvas, &cow, true, false);
+    for (uint32_t ty = 0; ty < tiles_y; ty++)
+        for (uint32_t tx = 0; tx < tiles_x; tx++)
+            direct[ty * tiles_x + tx] = canvas_tile_dirty(canvas, tx, ty);
+
+    canvas_dirty_reset(canvas);
+    clear_view_frame(canvas, &cow, true, true);
+    size_t dirty = 0, differing = 0;
+    for (uint32_t ty = 0; ty < tiles_y; ty++) {
+        for (uint32_t tx = 0; tx < tiles_x; tx++) {
+            bool binned = canvas_tile_dirty(canvas, tx, ty);
+            dirty += binned;
+            differing += binned != direct[ty * tiles_x + tx];
+        }
+    }
+    EXPECT(dirty > 0 && differing == 0);
+    free(direct);
+    obj_cleanup(&cow);
+}
+
+/**
+ * A translucent layer cleared eagerly or with canvas_clear, partly drawn over,
+ * blended whole and through a view off the tile grid, and blended again after
+ * a round trip through a PPM file. Blending and exporting read the pending
+ * clears of the layer without resolving them.
+ */
+static void clear_layer_draw(canvas_t *const canvas, bool fast) {
+    canvas_fill_rect(canvas, 0, HEIGHT / 3, WIDTH, HEIGHT / 3, C(0xFF3C8CF0));
+
+    canvas_t layer;
+    canvas_pool_acquire(&test_pool, &layer, 200, 120, COLOR_WHITE);
+    if (fast)
+        canvas_clear(&layer, C(0x80F03C8C));
+    else
+        canvas_fill(&layer, C(0x80F03C8C));
+    canvas_fill_circle(&layer, 60, 50, 30, C(0xFF202080));
+    canvas_fill_rect(&layer, 130, 70, 50, 40, C(0x4020C020));
+
+    canvas_blend_canvas(canvas, &layer, 20, 20);
+    canvas_blend_canvas(canvas, &layer, -50, HEIGHT - 80);
+    canvas_t view;
+    canvas_view(&view, &layer, 37, 5, 120, 90);
+    canvas_blend_canvas(canvas, &view, 300, 150);
+    canvas_cleanup(&view);
+
+    char path[] = "/tmp/moluvi-test-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+        canvas_render_ppm(&layer, path);
+        canvas_t loaded = canvas_load_ppm(path);
+        canvas_blend_canvas(canvas, &loaded, WIDTH - 220, 260);
+        canvas_cleanup(&loaded);
+        unlink(path);
+    }
+    canvas_pool_release(&test_pool, &layer);
+}
+
+void clear_layer_example(canvas_t *const canvas) {
+    clear_layer_draw(canvas, false);
+}
+
+// Must match clear_layer_example bit for bit
+void clear_layer_fast_example(canvas_t *const canvas) {
+    clear_layer_draw(canvas, true);
+}
+
+// A frame of 2D draws and the cow drawn directly, then the cow through a
+// binner, each drawn twice. The first pass grows the scratch space and bins
+// to fit; the second must not allocate at all. Ends on the binned cow, so it
+// must match mesh_draw_example bit for bit.
+void steady_state_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+    binner_t binner;
+    binner_init(&binner, canvas, 4);
+
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, MESH_SCALE, MESH_ANGLE);
+    uint64_t allocs[2];
+    for (int pass = 0; pass < 2; pass++) {
+        uint64_t start = heap_alloc_count();
+        canvas_clear(canvas, COLOR_WHITE);
+        canvas_fill_rect(canvas, 20, 20, 200, 100, C(0xFF3C8CF0));
+        canvas_fill_circle_aa(canvas, 400, 100, 60, C(0x80C35DFA));
+        canvas_draw_line(canvas, 0, 0, WIDTH - 1, HEIGHT - 1, COLOR_BLACK, 3);
+        canvas_write_string(canvas, "STEADY STATE", 20, 140, font_mojangles,
+                            2, COLOR_BLACK);
+        canvas_draw_mesh(canvas, &cow, &model, mesh_cam);
+
+        canvas_clear(canvas, COLOR_WHITE);
+        binner_draw_mesh(&binner, &cow, &model, mesh_cam);
+        binner_flush(&binner);
+        allocs[pass] = heap_alloc_count() - start;
+    }
+    EXPECT(allocs[0] > 0);
+    EXPECT(allocs[1] == 0);
+
+    binner_cleanup(&binner);
+    obj_cleanup(&cow);
+}
+
+// A split screen drawn through two views of the same canvas
+void views_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    for (int i = 0; i < 2; i++) {
+        canvas_t view;
+        struct camera cam;
+        view_split(&view, canvas, i, &cam);
+        struct transform model =
+            transform_model((point3_t){0, 0, 0}, MESH_SCALE, view_angle[i]);
+        canvas_draw_mesh(&view, &cow, &model, cam);
+        canvas_cleanup(&view);
+    }
+    obj_cleanup(&cow);
+}
+
+// Must match views_example bit for bit
+void views_binned_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    for (int i = 0; i < 2; i++) {
+        canvas_t view;
+        struct camera cam;
+        view_split(&view, canvas, i, &cam);
+        struct transform model =
+            transform_model((point3_t){0, 0, 0}, MESH_SCALE, view_angle[i]);
+        binner_t binner;
+        binner_init(&binner, &view, 4);
+        binner_draw_mesh(&binner, &cow, &model, cam);
+        binner_flush(&binner);
+        binner_cleanup(&binner);
+        canvas_cleanup(&view);
+    }
+    obj_cleanup(&cow);
+}
+
+static void cmd_run(canvas_t *const canvas, cmd_buffer_t *const cmds) {
+    binner_t binner;
+    binner_init(&binner, canvas, 4);
+    EXPECT(cmd_buffer_execute(cmds, &binner) == 0);
+    binner_cleanup(&binner);
+    cmd_buffer_cleanup(cmds);
+}
+
+// The examples below record their draws in a command buffer and must match
+// the immediate mode ones bit for bit
+void cmd_shapes_example(canvas_t *const canvas) {
+    cmd_buffer_t cmds;
+    cmd_buffer_init(&cmds);
+    cmd_fill_rect(&cmds, 4, 4, WIDTH - 8, HEIGHT - 8, C(0xFFD9A403));
+    cmd_fill_circle(&cmds, 0, 0, HEIGHT / 5, C(0xBBC35DFA));
+    cmd_fill_circle(&cmds, -20, -20, HEIGHT / 8, C(0xBA00B4D8));
+    cmd_fill_quad(&cmds, (point2_t){75, 200}, (point2_t){200, 20},
+                  (point2_t){300, 275}, (point2_t){500, 10}, C(0xFFFA0301));
+    cmd_fill_tri(&cmds, 200, 200, 300, 200, 500, 400, C(0x881AB3FD));
+    cmd_run(canvas, &cmds);
+}
+
+// cmd_shapes_example with a triangle beyond the guard band recorded in the
+// middle. It is skipped as canvas_fill_tri skips it, the commands after it
+// still draw, and cmd_buffer_execute returns the error canvas_fill_tri does.
+void cmd_error_example(canvas_t *const canvas) {
+    cmd_buffer_t cmds;
+    cmd_buffer_init(&cmds);
+    cmd_fill_rect(&cmds, 4, 4, WIDTH - 8, HEIGHT - 8, C(0xFFD9A403));
+    cmd_fill_circle(&cmds, 0, 0, HEIGHT / 5, C(0xBBC35DFA));
+    cmd_fill_tri(&cmds, -100000, 0, 100, 100, 0, 100, COLOR_BLACK);
+    cmd_fill_circle(&cmds, -20, -20, HEIGHT / 8, C(0xBA00B4D8));
+    cmd_fill_quad(&cmds, (point2_t){75, 200}, (point2_t){200, 20},
+                  (point2_t){300, 275}, (point2_t){500, 10}, C(0xFFFA0301));
+    cmd_fill_tri(&cmds, 200, 200, 300, 200, 500, 400, C(0x881AB3FD));
+
+    binner_t binner;
+    binner_init(&binner, canvas, 4);
+    int expected =
+        canvas_fill_tri(canvas, -100000, 0, 100, 100, 0, 100, COLOR_BLACK);
+    EXPECT(expected < 0);
+    EXPECT(cmd_buffer_execute(&cmds, &binner) == expected);
+    binner_cleanup(&binner);
+    cmd_buffer_cleanup(&cmds);
+}
+
+void cmd_lines_example(canvas_t *const canvas) {
+    cmd_buffer_t cmds;
+    cmd_buffer_init(&cmds);
+    cmd_draw_line(&cmds, 0, 0, WIDTH - 1, HEIGHT - 1, COLOR_BLACK, 1);
+    cmd_draw_line(&cmds, WIDTH - 1, 0, 0, HEIGHT - 1, COLOR_BLACK, 1);
+    cmd_draw_line(&cmds, WIDTH / 2, 0, WIDTH / 2, HEIGHT - 1, COLOR_BLACK, 1);
+    cmd_draw_line(&cmds, 0, HEIGHT / 2, WIDTH - 1, HEIGHT / 2, COLOR_BLACK, 1);
+    cmd_draw_line(&cmds, 0, 0, WIDTH - 1, HEIGHT / 2, COLOR_BLACK, 1);
+    cmd_draw_line(&cmds, WIDTH - 1, 0, 0, HEIGHT / 2, COLOR_BLACK, 1);
+    cmd_draw_line(&cmds, 0, HEIGHT - 1, WIDTH - 1, HEIGHT / 2, COLOR_BLACK, 1);
+    cmd_draw_line(&cmds, WIDTH - 1, HEIGHT - 1, 0, HEIGHT / 2, COLOR_BLACK, 1);
+    cmd_run(canvas, &cmds);
+}
+
+void cmd_thicc_lines_example(canvas_t *const canvas) {
+    uint32_t graph_origin_x = WIDTH / 2 - WIDTH / 4;
+    cmd_buffer_t cmds;
+    cmd_buffer_init(&cmds);
+    cmd_draw_line(&cmds, graph_origin_x, HEIGHT - 80,
+                  HEIGHT - 160 + graph_origin_x - 100, 180, COLOR_BLUE, 1);
+    cmd_draw_line(&cmds, graph_origin_x, HEIGHT - 80,
+                  HEIGHT - 160 + graph_origin_x - 200, 160, COLOR_RED, 1);
+    cmd_draw_line(&cmds, graph_origin_x, HEIGHT - 80,
+                  HEIGHT - 160 + graph_origin_x - 40, HEIGHT - 80 - 20,
+                  C(0xFF00DC00), 1);
+    cmd_draw_line(&cmds, graph_origin_x, 80, graph_origin_x, HEIGHT - 80,
+                  COLOR_BLACK, 3);
+    cmd_draw_line(&cmds, graph_origin_x, HEIGHT - 80,
+                  HEIGHT - 160 + graph_origin_x, HEIGHT - 80, COLOR_BLACK, 3);
+
+    const char *title = "Fruit Consumption vs All-cause Mortality";
+    int title_sz = strlen(title);
+    cmd_write_string(&cmds, title,
+                     WIDTH / 2 - (title_sz * font_mojangles.glyph_width) / 2,
+                     HEIGHT - 60, font_mojangles, 1, COLOR_BLACK);
+    cmd_run(canvas, &cmds);
+}
+
+void cmd_triangle_example(canvas_t *const canvas) {
+    cmd_buffer_t cmds;
+    cmd_buffer_init(&cmds);
+    cmd_fill_tri(&cmds, 0, 0, WIDTH / 2, 10, WIDTH / 2 - 10, HEIGHT / 2,
+                 COLOR_BLACK);
+    cmd_fill_tri(&cmds, 30, 40, 200, 70, 4, 369, C(0xBA2308FF));
+    cmd_fill_tri(&cmds, WIDTH / 2 - 90, HEIGHT / 2 - 20, 550, HEIGHT / 2 - 90,
+                 550, HEIGHT / 2 + 100, C(0xC3B8D908));
+    cmd_write_string(&cmds, "THESE ARE TRIANGLES", 10, HEIGHT - 20,
+                     font_mojangles, 2, COLOR_BLACK);
+    cmd_run(canvas, &cmds);
+}
+
+void cmd_circles_example(canvas_t *const canvas) {
+    cmd_buffer_t cmds;
+    cmd_buffer_init(&cmds);
+    for (uint32_t i = 0; i < 8; i++) {
+        uint32_t r = 2 + i * 4;
+        int64_t x = 20 + i * 75;
+        cmd_fill_circle(&cmds, x, HEIGHT / 4, r, C(0xFFB04010));
+        cmd_fill_circle_aa(&cmds, x, HEIGHT / 2, r, C(0xFFB04010));
+        cmd_fill_circle_aa(&cmds, x, 3 * HEIGHT / 4, r, C(0x802020E0));
+    }
+    cmd_fill_circle(&cmds, -10, -10, 60, COLOR_BLACK);
+    cmd_fill_circle_aa(&cmds, WIDTH + 10, HEIGHT + 10, 60, COLOR_BLACK);
+    cmd_run(canvas, &cmds);
+}
+
+void cmd_mesh_draw_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+
+    cmd_buffer_t cmds;
+    cmd_buffer_init(&cmds);
+    struct transform model =
+        transform_model((point3_t){0, 0, 0}, MESH_SCALE, MESH_ANGLE);
+    cmd_draw_mesh(&cmds, &cow, &model, mesh_cam);
+    cmd_run(canvas, &cmds);
+    obj_cleanup(&cow);
+}
+
+// A frame of a scene where only a circle, a spinning cow and a counter move
+static void dirty_frame(canvas_t *const canvas, obj_t *const cow, int frame) {
+    canvas_clear(canvas, COLOR_WHITE);
+    canvas_fill_rect(canvas, 40, 300, 200, 120, C(0xFF3C8CF0));
+    canvas_fill_circle_aa(canvas, 100 + frame * 60, 100, 30, C(0xFFB04010));
+    struct transform model = transform_model(
+        (point3_t){0, 0, 0}, MESH_SCALE, MESH_ANGLE + frame * 0.3);
+    canvas_draw_mesh(canvas, cow, &model, mesh_cam);
+
+    char text[16];
+    snprintf(text, sizeof(text), "FRAME %d", frame);
+    canvas_write_string(canvas, text, 10, HEIGHT - 30, font_mojangles, 2,
+                        COLOR_BLACK);
+}
+
+// Tracks a canvas through frames 0 and 1, leaving the tiles frame 1 changed
+// dirty
+static void dirty_frames(canvas_t *const canvas, obj_t *const cow) {
+    canvas_use_depth(canvas);
+    canvas_track_dirty(canvas);
+    dirty_frame(canvas, cow, 0);
+    canvas_resolve(canvas);
+    canvas_dirty_reset(canvas);
+    dirty_frame(canvas, cow, 1);
+}
+
+// Frame 1 with the outline of every dirty rectangle on top
+void dirty_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    dirty_frames(canvas, &cow);
+
+    arraylist_t rects;
+    ARRAY_MAKE(&rects, struct dirty_rect, 16);
+    int count = canvas_dirty_rects(canvas, &rects);
+    EXPECT(count > 0);
+    const struct dirty_rect *r = rects.data;
+    for (int i = 0; i < count; i++) {
+        uint32_t x1 = r[i].x + r[i].width - 1, y1 = r[i].y + r[i].height - 1;
+        canvas_draw_line(canvas, r[i].x, r[i].y, x1, r[i].y, COLOR_RED, 1);
+        canvas_draw_line(canvas, r[i].x, y1, x1, y1, COLOR_RED, 1);
+        canvas_draw_line(canvas, r[i].x, r[i].y, r[i].x, y1, COLOR_RED, 1);
+        canvas_draw_line(canvas, x1, r[i].y, x1, y1, COLOR_RED, 1);
+    }
+    array_cleanup(&rects);
+    obj_cleanup(&cow);
+}
+
+void dirty_frame_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+    dirty_frame(canvas, &cow, 1);
+    obj_cleanup(&cow);
+}
+
+// Frame 0 patched with the dirty tiles streamed from a canvas that went on to
+// draw frame 1. Must match dirty_frame_example bit for bit.
+void dirty_stream_example(canvas_t *const canvas) {
+    obj_t cow;
+    if (obj_load(&cow, "vendor/cow.obj") < 0)
+        return;
+    canvas_use_depth(canvas);
+    dirty_frame(canvas, &cow, 0);
+
+    canvas_t source;
+    canvas_pool_acquire(&test_pool, &source, WIDTH, HEIGHT, COLOR_WHITE);
+    dirty_frames(&source, &cow);
+
+    FILE *stream = tmpfile();
+    arraylist_t rects;
+    ARRAY_MAKE(&rects, struct dirty_rect, 16);
+    int count = canvas_write_dirty_ppm(&source, stream, &rects);
+    EXPECT(count > 0 && (size_t)count == rects.count);
+    rewind(stream);
+
+    uint32_t x, y, w, h;
+    while (fscanf(stream, "P6 # %u %u %u %u 255", &x, &y, &w, &h) == 4) {
+        fgetc(stream);
+        for (uint32_t iy = 0; iy < h; iy++) {
+            for (uint32_t ix = 0; ix < w; ix++) {
+                uint8_t rgb[3];
+                if (fread(rgb, 1, 3, stream) != 3)
+                    break;
+                canvas_set_px(canvas, x + ix, y + iy,
+                              (struct rgba){rgb[0], rgb[1], rgb[2], 255});
+            }
+        }
+    }
+
+    fclose(stream);
+    array_cleanup(&rects);
+    canvas_pool_release(&test_pool, &source);
+    obj_cleanup(&cow);
+}
+
+// text_example drawn twice through a text cache, the second time from the
+// cached runs. Must match text_example bit for bit.
+void text_cached_example(canvas_t *const canvas) {
+    text_cache_t cache;
+    if (text_cache_init(&cache, 1 << 20) < 0) {
+        EXPECT(!"text_cache_init failed");
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        canvas_fill(canvas, COLOR_WHITE);
+        canvas_write_string_cached(canvas, &cache,
+                                   "ABCDEFGHIJKLMNOPQRSTUVWXYZ", 20,
+                                   HEIGHT / 2, font_mojangles, 2, COLOR_BLACK);
+        canvas_write_string_cached(canvas, &cache,
+                                   "abcdefghijklmnopqrstuvwxyz", 20,
+                                   HEIGHT / 2 + 20, font_mojangles, 1,
+                                   COLOR_BLACK);
+    }
+    struct text_cache_stats stats = text_cache_stats(&cache);
+    EXPECT(stats.misses == 2 && stats.hits == 2 && stats.evictions == 0);
+    text_cache_cleanup(&cache);
+}
+
+static void text_edge_write(canvas_t *const canvas, text_cache_t *const cache,
+                            const char *str, uint32_t x, uint32_t y,
+                            uint32_t size, struct rgba color) {
+    if (cache)
+        canvas_write_string_cached(canvas, cache, str, x, y, font_mojangles,
+                                   size, color);
+    else
+        canvas_write_string(canvas, str, x, y, font_mojangles, size, color);
+}
+
+// Strings running off the right and bottom edges, opaque and translucent, and
+// written into a transparent layer so the alpha they leave is blended too
+static void text_edge_draw(canvas_t *const canvas, text_cache_t *const cache) {
+    static const char *const labels[] = {"FPS 60", "FPS 59", "ALLOCS 0",
+                                         "FRAME 1024", "FPS 60"};
+    canvas_fill_rect(canvas, 0, HEIGHT / 2, WIDTH, HEIGHT / 2,
+                     C(0xFF3C8CF0));
+    for (uint32_t i = 0; i < 5; i++) {
+        struct rgba color = i % 2 ? C(0x80202080) : COLOR_BLACK;
+        text_edge_write(canvas, cache, labels[i], 10 + i * 7, 10 + i * 40,
+                        1 + i, color);
+        text_edge_write(canvas, cache, labels[i], WIDTH - 60 - i * 20,
+                        60 + i * 50, 1 + i, color);
+    }
+    text_edge_write(canvas, cache, "BOTTOM EDGE", 200, HEIGHT - 20, 4,
+                    C(0xC0F0E0C8));
+
+    canvas_t layer;
+    canvas_pool_acquire(&test_pool, &layer, 200, 60, C(0x00000000));
+    text_edge_write(&layer, cache, "LAYER TEXT", 5, 5, 3, C(0x60FFFFFF));
+    text_edge_write(&layer, cache, "ALLOCS 0", 140, 40, 3, C(0xFF00C000));
+    canvas_blend_canvas(canvas, &layer, 300, 20);
+    canvas_blend_canvas(canvas, &layer, WIDTH - 120, HEIGHT / 2);
+    canvas_pool_release(&test_pool, &layer);
+}
+
+void text_edge_example(canvas_t *const canvas) {
+    text_edge_draw(canvas, NULL);
+}
+
+// text_edge_example through a cache too small to hold every run, so runs are
+// evicted and rendered again. Must match text_edge_example bit for bit.
+void text_edge_cached_example(canvas_t *const canvas) {
+    text_cache_t cache;
+    if (text_cache_init(&cache, 24 << 10) < 0) {
+        EXPECT(!"text_cache_init failed");
+        return;
+    }
+    for (int i = 0; i < 3; i++) {
+        canvas_fill(canvas, COLOR_WHITE);
+        text_edge_draw(canvas, &cache);
+    }
+    struct text_cache_stats stats = text_cache_stats(&cache);
+    EXPECT(stats.hits > 0 && stats.evictions > 0);
+    text_cache_cleanup(&cache);
+}
+
+#define SWAP_FRAMES 16
+#define SWAP_CELL_WIDTH (WIDTH / 4)
+#define SWAP_CELL_HEIGHT (HEIGHT / 4)
+
+static const uint32_t swap_palette[4] = {0xFFF0E0C8, 0xFFC8E0F0, 0xFFD0F0C8,
+                                         0xFFF0C8E0};
+
+static void swap_draw_frame(canvas_t *const canvas, uint64_t frame) {
+    canvas_fill(canvas, C(swap_palette[frame % 4]));
+    canvas_fill_circle(canvas, 20 + (int64_t)frame * 8, SWAP_CELL_HEIGHT / 2,
+                       20, C(0xFF3C8CF0));
+    char text[8];
+    snprintf(text, sizeof(text), "%02u", (unsigned)frame);
+    canvas_write_string(canvas, text, 10, 10, font_mojangles, 2, COLOR_BLACK);
+}
+
+static void swap_render(swap_chain_t *const chain) {
+    for (int i = 0; i < SWAP_FRAMES; i++) {
+        uint64_t frame;
+        canvas_t *buffer = swap_chain_acquire(chain, &frame);
+        if (!buffer)
+            break;
+        swap_draw_frame(buffer, frame);
+        swap_chain_submit(chain, buffer);
+    }
+}
+
+static void swap_present_grid(void *ctx, const canvas_t *frame_canvas,
+                              uint64_t frame) {
+    canvas_t *canvas = ctx;
+    canvas_blend_canvas(canvas, frame_canvas, (frame % 4) * SWAP_CELL_WIDTH,
+                        (frame / 4) * SWAP_CELL_HEIGHT);
+}
+
+// Every frame, presented in order on another thread into a cell of a grid
+void swap_fifo_example(canvas_t *const canvas) {
+    swap_chain_t chain;
+    if (swap_chain_init(&chain, SWAP_CELL_WIDTH, SWAP_CELL_HEIGHT, 3,
+                        SWAP_FIFO) < 0)
+        return;
+    swap_chain_present_async(&chain, &swap_present_grid, canvas);
+    swap_render(&chain);
+    swap_chain_cleanup(&chain);
+}
+
+struct swap_latest_ctx {
+    canvas_t *canvas;
+    int64_t last_frame;
+    bool ordered;
+};
+
+static void swap_present_latest(void *ctx, const canvas_t *frame_canvas,
+                                uint64_t frame) {
+    struct swap_latest_ctx *latest = ctx;
+    latest->ordered &= (int64_t)frame > latest->last_frame;
+    latest->last_frame = (int64_t)frame;
+    canvas_blend_canvas(latest->canvas, frame_canvas, WIDTH / 2 - 80,
+                        HEIGHT / 2 - 60);
+    usleep(500); // Slower than rendering, so frames get dropped
+}
+
+// Frames presented slower than they are drawn, through two buffers: only
+// newer frames are presented, the last one always is, and every frame is
+// either presented or dropped. A red canvas flags a broken rule.
+void swap_latest_example(canvas_t *const canvas) {
+    swap_chain_t chain;
+    if (swap_chain_init(&chain, SWAP_CELL_WIDTH, SWAP_CELL_HEIGHT, 2,
+                        SWAP_LATEST) < 0)
+        return;
+    struct swap_latest_ctx latest = {canvas, -1, true};
+    swap_chain_present_async(&chain, &swap_present_latest, &latest);
+    swap_render(&chain);
+    swap_chain_cleanup(&chain);
+
+    if (!latest.ordered || latest.last_frame != SWAP_FRAMES - 1 ||
+        chain.stats.presented + chain.stats.dropped != SWAP_FRAMES)
+        canvas_fill(canvas, COLOR_RED);
+}
+
 int main(int argc, char **argv) {
     nob_mkdir_if_not_exists(TEST_DIR);
 
@@ -261,11 +1455,87 @@ int main(int argc, char **argv) {
         exit(1);
     }
 
+    canvas_pool_init(&test_pool, NULL);
     test_case(&shapes_example, TEST_DIR "shapes.ppm", cmd, diff_mode);
     test_case(&lines_example, TEST_DIR "lines.ppm", cmd, diff_mode);
     test_case(&thicc_lines_example, TEST_DIR "thicc.ppm", cmd, diff_mode);
     test_case(&text_example, TEST_DIR "text.ppm", cmd, diff_mode);
     test_case(&triangle_example, TEST_DIR "tri.ppm", cmd, diff_mode);
+    test_case(&wide_triangle_example, TEST_DIR "tri_wide.ppm", cmd, diff_mode);
+    test_case(&circles_example, TEST_DIR "circles.ppm", cmd, diff_mode);
+    test_case(&layers_example, TEST_DIR "layers.ppm", cmd, diff_mode);
+    test_case(&mesh_example, TEST_DIR "mesh.ppm", cmd, diff_mode);
+    test_case(&mesh_binned_example, TEST_DIR "mesh.ppm", cmd, diff_mode);
+    test_case(&obj_float_example, TEST_DIR "mesh.ppm", cmd, diff_mode);
+    test_case(&pool_reuse_example, TEST_DIR "mesh.ppm", cmd, diff_mode);
+    test_case(&mesh_draw_example, TEST_DIR "mesh_draw.ppm", cmd, diff_mode);
+    test_case(&mesh_draw_binned_example, TEST_DIR "mesh_draw.ppm", cmd,
+              diff_mode);
+    test_case(&mesh_cache_example, TEST_DIR "mesh_draw.ppm", cmd, diff_mode);
+    test_case(&mesh_cache_mapped_example, TEST_DIR "mesh_draw.ppm", cmd,
+              diff_mode);
+    test_case(&mesh_clip_example, TEST_DIR "mesh_clip.ppm", cmd, diff_mode);
+    test_case(&mesh_clip_binned_example, TEST_DIR "mesh_clip.ppm", cmd,
+              diff_mode);
+    test_case(&mesh_cull_example, TEST_DIR "mesh_cull.ppm", cmd, diff_mode);
+    test_case(&mesh_cull_binned_example, TEST_DIR "mesh_cull.ppm", cmd,
+              diff_mode);
+    test_case(&mesh_draw_cull_example, TEST_DIR "mesh_draw_cull.ppm", cmd,
+              diff_mode);
+    test_case(&mesh_optimize_example, TEST_DIR "mesh_draw_cull.ppm", cmd,
+              diff_mode);
+    test_case(&lod_example, TEST_DIR "lod.ppm", cmd, diff_mode);
+    test_case(&lod_binned_example, TEST_DIR "lod.ppm", cmd, diff_mode);
+    test_case(&views_example, TEST_DIR "views.ppm", cmd, diff_mode);
+    test_case(&views_binned_example, TEST_DIR "views.ppm", cmd, diff_mode);
+    test_case(&depth_f32_rev_example, TEST_DIR "mesh_draw.ppm", cmd,
+              diff_mode);
+    test_case(&depth_unorm24_example, TEST_DIR "mesh_draw.ppm", cmd,
+              diff_mode);
+    test_case(&depth_unorm16_example, TEST_DIR "depth_unorm16.ppm", cmd,
+              diff_mode);
+    test_case(&depth_unorm16_binned_example, TEST_DIR "depth_unorm16.ppm", cmd,
+              diff_mode);
+    test_case(&depth_near_example, TEST_DIR "depth_near.ppm", cmd, diff_mode);
+    test_case(&depth_near_f32_rev_example, TEST_DIR "depth_near.ppm", cmd,
+              diff_mode);
+    test_case(&depth_near_unorm24_example, TEST_DIR "depth_near.ppm", cmd,
+              diff_mode);
+    test_case(&clear_example, TEST_DIR "clear.ppm", cmd, diff_mode);
+    test_case(&clear_fast_example, TEST_DIR "clear.ppm", cmd, diff_mode);
+    test_case(&clear_fast_binned_example, TEST_DIR "clear.ppm", cmd,
+              diff_mode);
+    test_case(&clear_view_repeat_example, TEST_DIR "clear.ppm", cmd,
+              diff_mode);
+    test_case(&clear_view_dirty_example, TEST_DIR "clear.ppm", cmd,
+              diff_mode);
+    test_case(&clear_layer_example, TEST_DIR "clear_layer.ppm", cmd,
+              diff_mode);
+    test_case(&clear_layer_fast_example, TEST_DIR "clear_layer.ppm", cmd,
+              diff_mode);
+    test_case(&steady_state_example, TEST_DIR "mesh_draw.ppm", cmd,
+              diff_mode);
+    test_case(&cmd_shapes_example, TEST_DIR "shapes.ppm", cmd, diff_mode);
+    test_case(&cmd_error_example, TEST_DIR "shapes.ppm", cmd, diff_mode);
+    test_case(&cmd_lines_example, TEST_DIR "lines.ppm", cmd, diff_mode);
+    test_case(&cmd_thicc_lines_example, TEST_DIR "thicc.ppm", cmd, diff_mode);
+    test_case(&cmd_triangle_example, TEST_DIR "tri.ppm", cmd, diff_mode);
+    test_case(&cmd_circles_example, TEST_DIR "circles.ppm", cmd, diff_mode);
+    test_case(&cmd_mesh_draw_example, TEST_DIR "mesh_draw.ppm", cmd,
+              diff_mode);
+    test_case(&dirty_example, TEST_DIR "dirty.ppm", cmd, diff_mode);
+    test_case(&dirty_frame_example, TEST_DIR "dirty_frame.ppm", cmd,
+              diff_mode);
+    test_case(&dirty_stream_example, TEST_DIR "dirty_frame.ppm", cmd,
+              diff_mode);
+    test_case(&text_cached_example, TEST_DIR "text.ppm", cmd, diff_mode);
+    test_case(&text_edge_example, TEST_DIR "text_edge.ppm", cmd, diff_mode);
+    test_case(&text_edge_cached_example, TEST_DIR "text_edge.ppm", cmd,
+              diff_mode);
+    test_case(&swap_fifo_example, TEST_DIR "swap_fifo.ppm", cmd, diff_mode);
+    test_case(&swap_latest_example, TEST_DIR "swap_latest.ppm", cmd,
+              diff_mode);
+    canvas_pool_cleanup(&test_pool);
 
     return 0;
 }
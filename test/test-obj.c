@@ -5,18 +5,16 @@
 #include <stdlib.h>
 
 void obj_print_vertices(const obj_t *const obj) {
-    for (size_t i = 0; i < obj->vertices.count; i += 3) {
-        printf("v %f %f %f\n", ARRAY_GET(float, &obj->vertices, i),
-               ARRAY_GET(float, &obj->vertices, i + 1),
-               ARRAY_GET(float, &obj->vertices, i + 2));
+    for (size_t i = 0; i < obj_vertex_count(obj); i++) {
+        point3_t v = obj_get_vertex(obj, i, 1);
+        printf("v %f %f %f\n", v.x, v.y, v.z);
     }
 }
 
 void obj_print_faces(const obj_t *const obj) {
-    for (size_t i = 0; i < obj->faces.count; i += 3) {
-        printf("f %zu %zu %zu\n", ARRAY_GET(size_t, &obj->faces, i),
-               ARRAY_GET(size_t, &obj->faces, i + 1),
-               ARRAY_GET(size_t, &obj->faces, i + 2));
+    for (size_t i = 0; i < obj_face_count(obj); i++) {
+        struct vec3z face = obj_get_face(obj, i);
+        printf("f %zu %zu %zu\n", face.x, face.y, face.z);
     }
 }
 